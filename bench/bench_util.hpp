@@ -0,0 +1,159 @@
+#ifndef BENCH_BENCH_UTIL_HPP
+#define BENCH_BENCH_UTIL_HPP
+
+#include <json/json.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+// Average wall time of one call to body over the given number of repetitions.
+template <typename F>
+double MeasureSeconds(int repetitions, F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i) {
+        body();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repetitions;
+}
+
+// In seconds; percentiles by nearest rank
+struct LatencySummary {
+    size_t count = 0;
+    double mean = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double max = 0;
+};
+
+// Sorts latencies
+inline LatencySummary Summarize(std::vector<double>& latencies) {
+    LatencySummary summary;
+    if (latencies.empty()) {
+        return summary;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(p * latencies.size());
+        return latencies[std::min(rank, latencies.size() - 1)];
+    };
+    double total = 0;
+    for (double latency : latencies) {
+        total += latency;
+    }
+    summary.count = latencies.size();
+    summary.mean = total / latencies.size();
+    summary.p50 = percentile(0.5);
+    summary.p99 = percentile(0.99);
+    summary.p999 = percentile(0.999);
+    summary.max = latencies.back();
+    return summary;
+}
+
+// Removes --json <path> or --json=<path> from the arguments, so the
+// positional ones keep their places
+inline std::optional<std::string> TakeJsonPath(int& argc, char** argv) {
+    std::optional<std::string> path;
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else if (std::strncmp(argv[i], "--json=", 7) == 0) {
+            path = argv[i] + 7;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    return path;
+}
+
+// One query per line; blank lines and lines starting with # are skipped
+inline std::vector<std::string> LoadQueryLog(const std::string& path) {
+    std::vector<std::string> queries;
+    std::ifstream in(path, std::ios::binary);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] != '#') {
+            queries.push_back(line);
+        }
+    }
+    return queries;
+}
+
+// The results of one benchmark run as a JSON object, for tracking them over
+// time next to the text output:
+//   {"benchmark": ..., "context": {...}, "results": [{"name": ..., <metrics>}]}
+class JsonReport {
+public:
+    explicit JsonReport(const std::string& benchmark) {
+        root_["benchmark"] = benchmark;
+        root_["context"]["unix_time"] = static_cast<Json::Int64>(std::time(nullptr));
+        root_["context"]["hardware_threads"] = std::thread::hardware_concurrency();
+#ifdef __VERSION__
+        root_["context"]["compiler"] = __VERSION__;
+#endif
+#ifdef NDEBUG
+        root_["context"]["assertions"] = false;
+#else
+        root_["context"]["assertions"] = true;
+#endif
+        root_["results"] = Json::Value(Json::arrayValue);
+    }
+
+    // Inputs and settings the results depend on
+    Json::Value& Context() { return root_["context"]; }
+
+    // A result to fill in with its metrics
+    Json::Value& Add(const std::string& name) {
+        Json::Value result;
+        result["name"] = name;
+        return root_["results"].append(result);
+    }
+
+    // Does nothing without a path
+    bool Write(const std::optional<std::string>& path) const {
+        if (!path) {
+            return true;
+        }
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "  ";
+        std::ofstream out(*path);
+        out << Json::writeString(builder, root_) << "\n";
+        if (!out) {
+            std::cerr << "cannot write " << *path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    Json::Value root_;
+};
+
+// Latencies in milliseconds
+inline void AddLatencies(Json::Value& result, const LatencySummary& summary) {
+    result["count"] = static_cast<Json::UInt64>(summary.count);
+    result["mean_ms"] = summary.mean * 1e3;
+    result["p50_ms"] = summary.p50 * 1e3;
+    result["p99_ms"] = summary.p99 * 1e3;
+    result["p999_ms"] = summary.p999 * 1e3;
+    result["max_ms"] = summary.max * 1e3;
+}
+
+} // namespace bench
+
+#endif // BENCH_BENCH_UTIL_HPP
@@ -0,0 +1,86 @@
+// Runs random boolean queries from many threads against one shared segment
+// and checks every answer against a single-threaded reference run.
+//
+// Usage: concurrent_query_stress <segment_file> [threads] [queries_per_thread]
+// Exits with status 1 if any concurrent result differs from the reference.
+
+#include "search/boolean_search.hpp"
+#include "search/index_segment.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t kDefaultThreads = 8;
+constexpr size_t kDefaultQueriesPerThread = 2000;
+constexpr size_t kDistinctQueries = 500;
+constexpr const char* kOperators[] = {" && ", " || ", " && !"};
+
+std::string RandomQuery(const search::IndexSegment& segment, std::mt19937& rng) {
+    std::uniform_int_distribution<size_t> pick_term(0, segment.TermCount() - 1);
+    std::uniform_int_distribution<size_t> pick_op(0, std::size(kOperators) - 1);
+    size_t terms = 1 + rng() % 3;
+    std::string query(segment.Term(pick_term(rng)));
+    for (size_t i = 1; i < terms; ++i) {
+        query += kOperators[pick_op(rng)];
+        // Unknown terms must not be inserted into the index
+        query += rng() % 8 == 0 ? std::string("несуществующее") : std::string(segment.Term(pick_term(rng)));
+    }
+    return rng() % 4 == 0 ? "(" + query + ")" : query;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <segment_file> [threads] [queries_per_thread]\n", argv[0]);
+        return 2;
+    }
+    auto segment = search::IndexSegment::Open(argv[1]);
+    if (!segment || segment->TermCount() == 0) {
+        std::fprintf(stderr, "cannot open segment %s\n", argv[1]);
+        return 2;
+    }
+    size_t num_threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : kDefaultThreads;
+    size_t queries_per_thread = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : kDefaultQueriesPerThread;
+
+    std::mt19937 rng(1);
+    std::vector<std::string> queries;
+    std::vector<search::PostingList> expected;
+    for (size_t i = 0; i < kDistinctQueries; ++i) {
+        queries.push_back(RandomQuery(*segment, rng));
+        expected.push_back(search::BooleanSearchRu(queries.back(), *segment).docs);
+    }
+    size_t term_count = segment->TermCount();
+
+    std::atomic<size_t> mismatches{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 local_rng(static_cast<uint32_t>(100 + t));
+            for (size_t i = 0; i < queries_per_thread; ++i) {
+                size_t q = local_rng() % queries.size();
+                if (search::BooleanSearchRu(queries[q], *segment).docs != expected[q]) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    size_t total = num_threads * queries_per_thread;
+    std::printf("threads=%zu queries=%zu elapsed=%.3f s qps=%.0f mismatches=%zu vocabulary %s\n",
+                num_threads, total, elapsed.count(), total / elapsed.count(), mismatches.load(),
+                segment->TermCount() == term_count ? "unchanged" : "CHANGED");
+    return mismatches.load() == 0 && segment->TermCount() == term_count ? 0 : 1;
+}
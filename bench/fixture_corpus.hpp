@@ -0,0 +1,266 @@
+#ifndef BENCH_FIXTURE_CORPUS_HPP
+#define BENCH_FIXTURE_CORPUS_HPP
+
+// Documents and queries for the macro-benchmarks, so they run without Mongo:
+// a synthetic Russian corpus, or a fixture file of one document per line.
+
+#include "database/document_source.hpp"
+#include "text_processing/utf8_converter.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// Draws straight from the engine: the std distributions differ between
+// standard libraries, and the corpus should not
+class Random {
+public:
+    explicit Random(uint32_t seed) : engine_(seed) {}
+    uint32_t Below(uint32_t n) { return engine_() % n; }
+    double Unit() { return engine_() / 4294967296.0; }
+
+private:
+    std::mt19937 engine_;
+};
+
+// Words ranked by frequency and drawn Zipf-distributed, as in running text.
+// Frequent Russian function words and word forms come first, then
+// pseudo-words of syllables and common endings, so inflection, stemming and
+// a long tail of rare terms all show up.
+class SyntheticVocabulary {
+public:
+    static constexpr size_t kSize = 60000;
+    static constexpr size_t kStopWords = 24; // the first ranks; never in queries
+
+    explicit SyntheticVocabulary(uint32_t seed) {
+        static const wchar_t* const kCommon[] = {
+            L"и", L"в", L"на", L"с", L"по", L"не", L"что", L"из", L"к", L"как", L"а", L"для",
+            L"от", L"о", L"это", L"он", L"его", L"был", L"до", L"также", L"их", L"при", L"который", L"года",
+            L"город", L"города", L"городе", L"городом", L"год", L"году", L"годы", L"район", L"района",
+            L"районе", L"война", L"войны", L"войне", L"страна", L"страны", L"стране", L"история",
+            L"истории", L"река", L"реки", L"реке", L"население", L"населения", L"университет",
+            L"университета", L"команда", L"команды", L"чемпионат", L"чемпионата", L"фильм", L"фильма",
+            L"фильме", L"альбом", L"альбома", L"музыка", L"музыки", L"школа", L"школы", L"церковь",
+            L"церкви", L"область", L"области", L"империя", L"империи", L"армия", L"армии", L"роман",
+            L"романа", L"книга", L"книги", L"писатель", L"писателя", L"художник", L"художника",
+            L"композитор", L"композитора", L"учёный", L"учёного", L"вид", L"вида", L"виды", L"семейство",
+            L"семейства", L"растение", L"растения", L"станция", L"станции", L"дорога", L"дороги",
+            L"железной", L"советский", L"советского", L"советской", L"российский", L"российской",
+            L"московский", L"московского", L"государственный", L"государственного", L"первый",
+            L"первого", L"первая", L"известный", L"известного", L"родился", L"родилась", L"основан",
+            L"основана", L"является", L"являлся", L"получил", L"получила", L"работал", L"работала",
+            L"участвовал", L"участвовала",
+        };
+        static const wchar_t* const kSyllables[] = {
+            L"ка", L"ро", L"ми", L"ст", L"ан", L"ов", L"ле", L"ти", L"на", L"по", L"ре", L"ва",
+            L"до", L"лу", L"че", L"зо", L"бра", L"гри", L"мо", L"ск", L"вер", L"пол", L"тр", L"ин",
+        };
+        static const wchar_t* const kEndings[] = {
+            L"", L"а", L"ы", L"ой", L"ами", L"ого", L"ий", L"ая", L"ость", L"ение", L"ился", L"ают",
+            L"ах", L"ом", L"ов", L"е",
+        };
+        words_.assign(std::begin(kCommon), std::end(kCommon));
+        common_ = words_.size();
+        Random random(seed);
+        while (words_.size() < kSize) {
+            std::wstring word;
+            for (uint32_t n = 2 + random.Below(3); n > 0; --n) {
+                word += kSyllables[random.Below(std::size(kSyllables))];
+            }
+            const wchar_t* ending = kEndings[random.Below(std::size(kEndings))];
+            words_.push_back(word + ending);
+        }
+        double total = 0;
+        cumulative_.reserve(kSize);
+        for (size_t rank = 0; rank < kSize; ++rank) {
+            total += 1.0 / (rank + 1);
+            cumulative_.push_back(total);
+        }
+    }
+
+    size_t Size() const { return words_.size(); }
+    // Real Russian forms at the top of the ranking
+    size_t CommonCount() const { return common_; }
+    const std::wstring& Word(size_t rank) const { return words_[rank]; }
+
+    size_t Draw(Random& random) const {
+        double target = random.Unit() * cumulative_.back();
+        auto it = std::upper_bound(cumulative_.begin(), cumulative_.end(), target);
+        return std::min<size_t>(it - cumulative_.begin(), kSize - 1);
+    }
+
+private:
+    std::vector<std::wstring> words_;
+    std::vector<double> cumulative_;
+    size_t common_ = 0;
+};
+
+inline std::wstring Capitalized(std::wstring word) {
+    if (!word.empty() && word[0] >= L'а' && word[0] <= L'я') {
+        word[0] = static_cast<wchar_t>(word[0] - (L'а' - L'А'));
+    } else if (!word.empty() && word[0] == L'ё') {
+        word[0] = L'Ё';
+    }
+    return word;
+}
+
+// A fixed set of documents served the way the indexer reads the collection.
+class FixtureCorpus : public database::DocumentSource {
+public:
+    static constexpr int kFirstCreatedAt = 1600000000;
+
+    // About 350 words per document; the same documents for a given seed
+    // everywhere
+    static FixtureCorpus Synthetic(size_t doc_count, uint32_t seed = 1) {
+        static const wchar_t* const kLatin[] = {L"Wikipedia", L"FIFA", L"NASA", L"BBC", L"IBM"};
+        SyntheticVocabulary vocabulary(seed);
+        Random random(seed + 1);
+        std::vector<database::Document> documents(doc_count);
+        for (size_t i = 0; i < doc_count; ++i) {
+            std::wstring title = Capitalized(vocabulary.Word(vocabulary.CommonCount() + random.Below(2000)));
+            title += L" ";
+            title += vocabulary.Word(vocabulary.Draw(random));
+            std::wstring text;
+            size_t words = 50 + random.Below(600);
+            bool sentence_start = true;
+            for (size_t w = 0; w < words; ++w) {
+                uint32_t kind = random.Below(100);
+                std::wstring word;
+                if (kind == 0) {
+                    word = kLatin[random.Below(std::size(kLatin))];
+                } else if (kind <= 2) {
+                    word = std::to_wstring(1700 + random.Below(324));
+                } else {
+                    word = vocabulary.Word(vocabulary.Draw(random));
+                }
+                text += sentence_start ? Capitalized(word) : word;
+                uint32_t punctuation = random.Below(12);
+                sentence_start = punctuation == 0;
+                text += punctuation == 0 ? L". " : punctuation == 1 ? L", " : L" ";
+            }
+            documents[i] = MakeDocument(i, text_processing::WstringToUtf8(title),
+                                        text_processing::WstringToUtf8(text));
+        }
+        return FixtureCorpus(std::move(documents));
+    }
+
+    // One document per line, either its text or title<TAB>text. Empty if the
+    // file cannot be read.
+    static FixtureCorpus Load(const std::string& path) {
+        std::vector<database::Document> documents;
+        std::ifstream in(path, std::ios::binary);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty()) {
+                continue;
+            }
+            auto tab = line.find('\t');
+            std::string title = tab == std::string::npos ? "" : line.substr(0, tab);
+            std::string text = tab == std::string::npos ? line : line.substr(tab + 1);
+            documents.push_back(MakeDocument(documents.size(), std::move(title), std::move(text)));
+        }
+        return FixtureCorpus(std::move(documents));
+    }
+
+    const std::vector<database::Document>& Documents() const { return documents_; }
+
+    // Of the text, as the indexer counts it
+    size_t Bytes() const {
+        size_t bytes = 0;
+        for (const auto& doc : documents_) {
+            bytes += doc.text.size();
+        }
+        return bytes;
+    }
+
+    // Copies, like documents decoded from a cursor
+    void StreamDocuments(size_t batch_size,
+                         const std::function<void(std::vector<database::Document>&&)>& consumer) override {
+        StreamDocumentsSince(0, batch_size, consumer);
+    }
+
+    void StreamDocumentsSince(int created_at, size_t batch_size,
+                              const std::function<void(std::vector<database::Document>&&)>& consumer) override {
+        std::vector<database::Document> batch;
+        for (const auto& doc : documents_) {
+            if (doc.created_at < created_at) {
+                continue;
+            }
+            batch.push_back(doc);
+            if (batch.size() == batch_size) {
+                consumer(std::move(batch));
+                batch = {};
+            }
+        }
+        if (!batch.empty()) {
+            consumer(std::move(batch));
+        }
+    }
+
+    size_t CountDocuments() override { return documents_.size(); }
+
+private:
+    explicit FixtureCorpus(std::vector<database::Document> documents) : documents_(std::move(documents)) {}
+
+    static database::Document MakeDocument(size_t ordinal, std::string title, std::string text) {
+        char id[32];
+        std::snprintf(id, sizeof(id), "%024zx", ordinal + 1);
+        database::Document doc{};
+        doc.id = id;
+        doc.pageid = static_cast<int>(ordinal + 1);
+        doc.url = "https://ru.wikipedia.org/?curid=" + std::to_string(doc.pageid);
+        doc.title = std::move(title);
+        doc.created_at = kFirstCreatedAt + static_cast<int>(ordinal);
+        doc.text = std::move(text);
+        return doc;
+    }
+
+    std::vector<database::Document> documents_;
+};
+
+// Queries of every operator over the synthetic vocabulary, mostly of its
+// frequent content words
+inline std::vector<std::string> SyntheticQueries(size_t count, uint32_t seed = 1) {
+    SyntheticVocabulary vocabulary(seed);
+    Random random(seed + 2);
+    auto word = [&]() {
+        size_t rank;
+        do {
+            rank = vocabulary.Draw(random);
+        } while (rank < SyntheticVocabulary::kStopWords);
+        return text_processing::WstringToUtf8(vocabulary.Word(rank));
+    };
+    std::vector<std::string> queries;
+    queries.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        switch (random.Below(8)) {
+            case 0: queries.push_back(word()); break;
+            case 1: queries.push_back(word() + " && " + word()); break;
+            case 2: queries.push_back(word() + " || " + word()); break;
+            case 3: queries.push_back(word() + " && " + word() + " && " + word()); break;
+            case 4: queries.push_back(word() + " && !" + word()); break;
+            case 5: queries.push_back("(" + word() + " || " + word() + ") && " + word()); break;
+            case 6: queries.push_back("\"" + word() + " " + word() + "\""); break;
+            default: {
+                std::wstring prefix = vocabulary.Word(SyntheticVocabulary::kStopWords +
+                                                      random.Below(vocabulary.CommonCount() -
+                                                                   SyntheticVocabulary::kStopWords));
+                prefix.resize(std::min<size_t>(prefix.size(), 4));
+                queries.push_back(text_processing::WstringToUtf8(prefix) + "*");
+            }
+        }
+    }
+    return queries;
+}
+
+} // namespace bench
+
+#endif // BENCH_FIXTURE_CORPUS_HPP
@@ -0,0 +1,162 @@
+// Insert, lookup and iteration cost of containers::HashMap/HashSet against the
+// previous chained implementation (bench/legacy_containers.hpp).
+//
+// Usage: hash_container_bench [--json <path>] [segment_file]
+//   With a segment file the real term vocabulary of that index is used,
+//   otherwise a synthetic Cyrillic vocabulary.
+
+#include "bench_util.hpp"
+#include "legacy_containers.hpp"
+#include "containers/hash_map.hpp"
+#include "containers/hash_set.hpp"
+#include "search/index_segment.hpp"
+#include "text_processing/utf8_converter.hpp"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kSyntheticVocabularySize = 200000;
+constexpr size_t kTokenStreamLength = 2000000;
+constexpr size_t kSmallSetCount = 200000;
+constexpr int kRepetitions = 3;
+
+std::vector<std::wstring> LoadVocabulary(const char* segment_path) {
+    std::vector<std::wstring> vocabulary;
+    if (segment_path) {
+        auto segment = search::IndexSegment::Open(segment_path);
+        if (!segment) {
+            std::fprintf(stderr, "cannot open segment %s\n", segment_path);
+            return vocabulary;
+        }
+        for (size_t i = 0; i < segment->TermCount(); ++i) {
+            vocabulary.push_back(text_processing::Utf8ToWstring(std::string(segment->Term(i))));
+        }
+        return vocabulary;
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> letter(L'а', L'я');
+    std::geometric_distribution<int> extra_length(0.3);
+    containers::HashSet<std::wstring> seen;
+    while (vocabulary.size() < kSyntheticVocabularySize) {
+        std::wstring word(2 + extra_length(rng), L' ');
+        for (auto& c : word) c = static_cast<wchar_t>(letter(rng));
+        if (!seen.Contains(word)) {
+            seen.Insert(word);
+            vocabulary.push_back(word);
+        }
+    }
+    return vocabulary;
+}
+
+// Term indexes drawn from a Zipf-like distribution, as in running text
+std::vector<size_t> MakeTokenStream(size_t vocabulary_size) {
+    std::mt19937 rng(11);
+    std::vector<double> weights(vocabulary_size);
+    for (size_t i = 0; i < vocabulary_size; ++i) weights[i] = 1.0 / (i + 1);
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    std::vector<size_t> stream(kTokenStreamLength);
+    for (auto& idx : stream) idx = pick(rng);
+    return stream;
+}
+
+void Report(bench::JsonReport& report, const char* name, size_t ops, double legacy_sec, double flat_sec) {
+    std::printf("%-22s ops=%-9zu legacy=%8.1f Mops/s flat=%8.1f Mops/s speedup=%.2fx\n",
+                name, ops, ops / legacy_sec / 1e6, ops / flat_sec / 1e6, legacy_sec / flat_sec);
+    auto& result = report.Add(name);
+    result["ops"] = static_cast<Json::UInt64>(ops);
+    result["legacy_mops_per_sec"] = ops / legacy_sec / 1e6;
+    result["flat_mops_per_sec"] = ops / flat_sec / 1e6;
+}
+
+template <typename Map>
+void InsertAll(Map& map, const std::vector<std::wstring>& vocabulary) {
+    for (const auto& term : vocabulary) map[term] = 1;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    auto json_path = bench::TakeJsonPath(argc, argv);
+    auto vocabulary = LoadVocabulary(argc > 1 ? argv[1] : nullptr);
+    if (vocabulary.empty()) return 1;
+    auto stream = MakeTokenStream(vocabulary.size());
+    std::printf("vocabulary=%zu terms, token stream=%zu\n", vocabulary.size(), stream.size());
+
+    bench::JsonReport report("hash_container_bench");
+    report.Context()["input"] = argc > 1 ? argv[1] : "synthetic";
+    report.Context()["vocabulary"] = static_cast<Json::UInt64>(vocabulary.size());
+    report.Context()["token_stream"] = static_cast<Json::UInt64>(stream.size());
+    report.Context()["repetitions"] = kRepetitions;
+
+    double legacy_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        legacy::HashMap<std::wstring, size_t> map;
+        InsertAll(map, vocabulary);
+    });
+    double flat_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        containers::HashMap<std::wstring, size_t> map;
+        InsertAll(map, vocabulary);
+    });
+    Report(report, "insert vocabulary", vocabulary.size(), legacy_sec, flat_sec);
+
+    legacy::HashMap<std::wstring, size_t> legacy_map;
+    containers::HashMap<std::wstring, size_t> flat_map;
+    InsertAll(legacy_map, vocabulary);
+    InsertAll(flat_map, vocabulary);
+
+    legacy_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        for (size_t idx : stream) legacy_map[vocabulary[idx]]++;
+    });
+    flat_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        for (size_t idx : stream) flat_map[vocabulary[idx]]++;
+    });
+    Report(report, "count token stream", stream.size(), legacy_sec, flat_sec);
+
+    volatile size_t sink = 0;
+    legacy_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        size_t sum = 0;
+        for (const auto& node : legacy_map) sum += node.value;
+        sink = sink + sum;
+    });
+    flat_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        size_t sum = 0;
+        for (const auto& node : flat_map) sum += node.value;
+        sink = sink + sum;
+    });
+    Report(report, "iterate", vocabulary.size(), legacy_sec, flat_sec);
+
+    // The legacy map has no lookup that does not insert, so misses are
+    // measured against a copy and only for the flat map's Find
+    std::vector<std::wstring> misses;
+    for (size_t i = 0; i < vocabulary.size(); ++i) misses.push_back(vocabulary[i] + L"ъ");
+    flat_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        size_t found = 0;
+        for (const auto& term : misses) found += flat_map.Contains(term);
+        sink = sink + found;
+    });
+    std::printf("%-22s ops=%-9zu flat=%8.1f Mops/s\n", "lookup miss", misses.size(), misses.size() / flat_sec / 1e6);
+    auto& miss_result = report.Add("lookup miss");
+    miss_result["ops"] = static_cast<Json::UInt64>(misses.size());
+    miss_result["flat_mops_per_sec"] = misses.size() / flat_sec / 1e6;
+
+    // Rare terms used to get a whole HashSet<ObjectId> posting set each
+    std::vector<std::string> object_ids(kSmallSetCount);
+    for (size_t i = 0; i < object_ids.size(); ++i) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%024zx", i);
+        object_ids[i] = buffer;
+    }
+    legacy_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        std::vector<legacy::HashSet<std::string>> sets(kSmallSetCount);
+        for (size_t i = 0; i < sets.size(); ++i) sets[i].Insert(object_ids[i]);
+    });
+    flat_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        std::vector<containers::HashSet<std::string>> sets(kSmallSetCount);
+        for (size_t i = 0; i < sets.size(); ++i) sets[i].Insert(object_ids[i]);
+    });
+    Report(report, "single-element sets", kSmallSetCount, legacy_sec, flat_sec);
+    return report.Write(json_path) ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// Closed-loop load generator for a running server: every connection sends
+// the next query of the log to POST /search and waits for the response
+// before sending another. Reports QPS and p50/p99/p999 latency of the
+// successful requests; requests during the warm-up are not counted.
+//
+// Usage: http_load_bench [--json <path>] <host> <port> <query_log> [connections] [seconds] [ranked]
+//   query_log has one query per line, e.g. bench/fixtures/queries_ru.txt.
+//   ranked 1 asks for BM25-ranked pages.
+
+#include "bench_util.hpp"
+#include <httplib.h>
+#include <json/json.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kDefaultConnections = 8;
+constexpr double kDefaultSeconds = 10;
+constexpr double kWarmupSeconds = 2;
+constexpr Json::UInt kPageSize = 20;
+constexpr const char* kContentTypeJson = "application/json";
+
+std::string SearchBody(const std::string& query, bool ranked) {
+    Json::Value root;
+    root["query"] = query;
+    root["limit"] = kPageSize;
+    root["ranked"] = ranked;
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, root);
+}
+
+Clock::duration Seconds(double seconds) {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+struct ConnectionResult {
+    std::vector<double> latencies;
+    size_t errors = 0;
+};
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    auto json_path = bench::TakeJsonPath(argc, argv);
+    if (argc < 4) {
+        std::fprintf(stderr, "usage: %s [--json <path>] <host> <port> <query_log> [connections] [seconds] [ranked]\n",
+                     argv[0]);
+        return 2;
+    }
+    std::string host = argv[1];
+    int port = std::atoi(argv[2]);
+    auto queries = bench::LoadQueryLog(argv[3]);
+    if (queries.empty()) {
+        std::fprintf(stderr, "no queries in %s\n", argv[3]);
+        return 2;
+    }
+    size_t connections = std::max<size_t>(1, argc > 4 ? std::strtoull(argv[4], nullptr, 10) : kDefaultConnections);
+    double seconds = argc > 5 ? std::atof(argv[5]) : kDefaultSeconds;
+    bool ranked = argc > 6 && std::atoi(argv[6]) != 0;
+
+    std::vector<std::string> bodies;
+    for (const auto& query : queries) {
+        bodies.push_back(SearchBody(query, ranked));
+    }
+
+    auto measure_from = Clock::now() + Seconds(kWarmupSeconds);
+    auto stop_at = measure_from + Seconds(seconds);
+
+    std::vector<ConnectionResult> results(connections);
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < connections; ++c) {
+        threads.emplace_back([&, c]() {
+            httplib::Client client(host, port);
+            client.set_keep_alive(true);
+            auto& result = results[c];
+            // Connections start at different places in the log
+            for (size_t i = c * bodies.size() / connections;; ++i) {
+                auto request_start = Clock::now();
+                if (request_start >= stop_at) {
+                    break;
+                }
+                auto response = client.Post("/search", bodies[i % bodies.size()], kContentTypeJson);
+                auto request_end = Clock::now();
+                if (request_start < measure_from) {
+                    continue;
+                }
+                if (!response || response->status != 200) {
+                    result.errors++;
+                    continue;
+                }
+                std::chrono::duration<double> latency = request_end - request_start;
+                result.latencies.push_back(latency.count());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Requests still running at stop_at finish after it; they count, so the
+    // measured time runs to the last of them
+    std::chrono::duration<double> measured = Clock::now() - measure_from;
+    std::vector<double> latencies;
+    size_t errors = 0;
+    for (const auto& result : results) {
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        errors += result.errors;
+    }
+    auto summary = bench::Summarize(latencies);
+    double qps = summary.count / measured.count();
+
+    std::printf("%s:%d connections=%zu seconds=%.1f ranked=%d\n", host.c_str(), port, connections, measured.count(),
+                ranked);
+    std::printf("qps=%.0f p50=%.3f ms p99=%.3f ms p999=%.3f ms max=%.3f ms requests=%zu errors=%zu\n", qps,
+                summary.p50 * 1e3, summary.p99 * 1e3, summary.p999 * 1e3, summary.max * 1e3, summary.count, errors);
+
+    bench::JsonReport report("http_load_bench");
+    report.Context()["server"] = host + ":" + std::to_string(port);
+    report.Context()["query_log"] = argv[3];
+    report.Context()["queries"] = static_cast<Json::UInt64>(queries.size());
+    report.Context()["connections"] = static_cast<Json::UInt64>(connections);
+    report.Context()["warmup_seconds"] = kWarmupSeconds;
+    report.Context()["seconds"] = measured.count();
+    report.Context()["ranked"] = ranked;
+    report.Context()["page_size"] = kPageSize;
+    auto& result = report.Add(ranked ? "search_ranked" : "search");
+    result["qps"] = qps;
+    bench::AddLatencies(result, summary);
+    result["errors"] = static_cast<Json::UInt64>(errors);
+    return report.Write(json_path) && errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+// Index build through indexing::Indexer from a fixture corpus instead of
+// Mongo, without and with positions: MB/s of text, the time of each phase,
+// the stem cache and the size of the segment.
+//
+// Usage: index_build_bench [--json <path>] [doc_count|corpus_file] [threads] [stemmer] [segment_out]
+//   A number builds from that many synthetic documents (default 20000), a
+//   file from one document per line (bench/fixture_corpus.hpp). threads 0
+//   uses one per core. The segment without positions is saved to
+//   segment_out, e.g. for query_replay_bench or concurrent_query_stress.
+
+#include "bench_util.hpp"
+#include "fixture_corpus.hpp"
+#include "indexing/indexer.hpp"
+#include "text_processing/stemmer.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+constexpr size_t kDefaultSyntheticDocs = 20000;
+constexpr size_t kDefaultThreads = 1;
+constexpr int kRepetitions = 3;
+
+bool IsCount(const char* arg) {
+    return *arg && std::all_of(arg, arg + std::strlen(arg), [](unsigned char c) { return std::isdigit(c); });
+}
+
+bench::FixtureCorpus LoadCorpus(const char* arg) {
+    if (!arg) {
+        return bench::FixtureCorpus::Synthetic(kDefaultSyntheticDocs);
+    }
+    return IsCount(arg) ? bench::FixtureCorpus::Synthetic(std::strtoull(arg, nullptr, 10))
+                        : bench::FixtureCorpus::Load(arg);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    auto json_path = bench::TakeJsonPath(argc, argv);
+    auto corpus = LoadCorpus(argc > 1 ? argv[1] : nullptr);
+    if (corpus.Documents().empty()) {
+        std::fprintf(stderr, "no documents\n");
+        return 1;
+    }
+    size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : kDefaultThreads;
+    auto stemmer = text_processing::ParseStemmer(argc > 3 ? argv[3] : "light");
+    if (!stemmer) {
+        std::fprintf(stderr, "unknown stemmer %s\n", argv[3]);
+        return 2;
+    }
+    const char* segment_out = argc > 4 ? argv[4] : nullptr;
+    double megabytes = corpus.Bytes() / 1e6;
+    std::printf("docs=%zu input=%.1f MB stemmer=%s\n", corpus.Documents().size(), megabytes,
+                text_processing::StemmerName(*stemmer));
+
+    bench::JsonReport report("index_build_bench");
+    report.Context()["input"] = argc > 1 && !IsCount(argv[1]) ? argv[1] : "synthetic";
+    report.Context()["docs"] = static_cast<Json::UInt64>(corpus.Documents().size());
+    report.Context()["input_mb"] = megabytes;
+    report.Context()["stemmer"] = text_processing::StemmerName(*stemmer);
+    report.Context()["repetitions"] = kRepetitions;
+
+    for (bool positions : {false, true}) {
+        indexing::IndexerOptions options;
+        options.num_threads = threads;
+        options.positions = positions;
+        options.stemmer = *stemmer;
+
+        // The fastest of the repetitions; the rest only differ by noise
+        indexing::IndexingStats best{};
+        size_t terms = 0, segment_bytes = 0;
+        for (int i = 0; i < kRepetitions; ++i) {
+            indexing::Indexer indexer(corpus, options);
+            indexer.BuildIndex();
+            auto stats = indexer.GetStats();
+            if (i == 0 || stats.elapsed_seconds < best.elapsed_seconds) {
+                best = stats;
+            }
+            const auto& segment = *indexer.Snapshot()->Segments().front().segment;
+            terms = segment.TermCount();
+            segment_bytes = segment.Size();
+            if (!positions && segment_out && i == 0) {
+                indexer.SaveIndex(segment_out);
+            }
+        }
+
+        const char* name = positions ? "build_positions" : "build";
+        std::printf("%-16s threads=%-3zu %7.3f s %7.1f MB/s tokens=%zu terms=%zu segment=%.1f MB "
+                    "fetch=%.3f s tokenize=%.3f s merge=%.3f s\n",
+                    name, best.threads, best.elapsed_seconds, megabytes / best.elapsed_seconds, best.total_tokens,
+                    terms, segment_bytes / 1e6, best.fetch_seconds, best.tokenize_seconds, best.merge_seconds);
+
+        auto& result = report.Add(name);
+        result["threads"] = static_cast<Json::UInt64>(best.threads);
+        result["seconds"] = best.elapsed_seconds;
+        result["mb_per_sec"] = megabytes / best.elapsed_seconds;
+        result["docs_per_sec"] = corpus.Documents().size() / best.elapsed_seconds;
+        result["tokens"] = static_cast<Json::UInt64>(best.total_tokens);
+        result["terms"] = static_cast<Json::UInt64>(terms);
+        result["segment_bytes"] = static_cast<Json::UInt64>(segment_bytes);
+        result["fetch_seconds"] = best.fetch_seconds;
+        result["tokenize_seconds"] = best.tokenize_seconds;
+        result["merge_seconds"] = best.merge_seconds;
+        result["stem_cache_hits"] = static_cast<Json::UInt64>(best.stem_cache_hits);
+        result["stem_cache_misses"] = static_cast<Json::UInt64>(best.stem_cache_misses);
+    }
+    return report.Write(json_path) ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+#ifndef BENCH_LEGACY_STEMMER_HPP
+#define BENCH_LEGACY_STEMMER_HPP
+
+// The linear scan over kEndings StemRu used before the suffix automaton,
+// kept as the baseline for stemmer_bench.
+
+#include <string>
+#include <vector>
+
+namespace legacy {
+
+inline std::wstring StemRu(const std::wstring& word) {
+    static const std::vector<std::wstring> kEndings = {
+        L"иями", L"ями", L"ами",
+        L"ией", L"ий", L"ый", L"ой",
+        L"ия", L"ья", L"ие", L"ье",
+        L"ых", L"ую", L"юю",
+        L"ая", L"яя",
+        L"ом", L"ем",
+        L"ах", L"ях",
+        L"ы", L"и", L"а", L"я", L"о", L"е", L"у", L"ю"
+    };
+    constexpr size_t kMinWordLength = 3;
+    constexpr size_t kMinStemLength = 2;
+
+    if (word.length() <= kMinWordLength)
+        return word;
+
+    for (const auto& end : kEndings) {
+        if (word.length() > end.length() + kMinStemLength &&
+            word.compare(word.length() - end.length(), end.length(), end) == 0) {
+            return word.substr(0, word.length() - end.length());
+        }
+    }
+    return word;
+}
+
+} // namespace legacy
+
+#endif // BENCH_LEGACY_STEMMER_HPP
@@ -0,0 +1,46 @@
+#ifndef BENCH_LEGACY_TOKENIZER_HPP
+#define BENCH_LEGACY_TOKENIZER_HPP
+
+// The wstring_convert + towlower tokenizer TokenizeRu used before it worked
+// on UTF-8 bytes, kept as the baseline for tokenizer_bench.
+
+#include <codecvt>
+#include <cwctype>
+#include <locale>
+#include <string>
+#include <vector>
+
+namespace legacy {
+
+inline bool IsRussianLetter(wchar_t c) {
+    return (c >= L'а' && c <= L'я') || (c >= L'А' && c <= L'Я') || c == L'ё' || c == L'Ё';
+}
+
+inline std::vector<std::wstring> TokenizeRu(const std::string& text) {
+    static thread_local std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+    std::wstring wtext = converter.from_bytes(text);
+
+    for (auto& c : wtext)
+        c = towlower(c);
+
+    std::vector<std::wstring> tokens;
+    std::wstring current;
+
+    for (wchar_t c : wtext) {
+        if (IsRussianLetter(c)) {
+            current += c;
+        } else if (!current.empty()) {
+            tokens.push_back(current);
+            current.clear();
+        }
+    }
+
+    if (!current.empty())
+        tokens.push_back(current);
+
+    return tokens;
+}
+
+} // namespace legacy
+
+#endif // BENCH_LEGACY_TOKENIZER_HPP
@@ -0,0 +1,113 @@
+// Decode and intersection throughput of compressed vs. plain posting lists,
+// and of the array/bitmap intersection kernels.
+//
+// Usage: posting_list_bench [num_docs]
+
+#include "bench_util.hpp"
+#include "search/compressed_posting_list.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+constexpr size_t kDefaultNumDocs = 1000000;
+constexpr int kRepetitions = 20;
+constexpr double kDensities[] = {0.001, 0.01, 0.1, 0.5, 0.9};
+
+search::PostingList MakePostings(size_t num_docs, double density, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution take(density);
+    search::PostingList postings;
+    for (size_t i = 0; i < num_docs; ++i) {
+        if (take(rng)) {
+            postings.push_back(static_cast<search::DocID>(i));
+        }
+    }
+    return postings;
+}
+
+void BenchDecode(size_t num_docs, double density) {
+    auto postings = MakePostings(num_docs, density, 42);
+    search::CompressedPostingList compressed(postings);
+
+    volatile uint64_t sink = 0;
+    double plain_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        uint64_t sum = 0;
+        for (search::DocID doc_id : postings) sum += doc_id;
+        sink = sink + sum;
+    });
+    double compressed_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        uint64_t sum = 0;
+        for (search::PostingListCursor cursor(compressed.View()); !cursor.AtEnd(); cursor.Next()) {
+            sum += cursor.Doc();
+        }
+        sink = sink + sum;
+    });
+
+    double plain_bytes = postings.size() * sizeof(search::DocID);
+    std::printf("decode    density=%-6g docs=%-8zu plain=%8.1f Mdocs/s compressed=%8.1f Mdocs/s "
+                "bytes/doc=%.2f (plain %.2f)\n",
+                density, postings.size(),
+                postings.size() / plain_sec / 1e6, postings.size() / compressed_sec / 1e6,
+                postings.empty() ? 0.0 : (double)compressed.MemoryUsage() / postings.size(),
+                postings.empty() ? 0.0 : plain_bytes / postings.size());
+}
+
+void BenchIntersect(size_t num_docs, double rare_density, double common_density) {
+    auto rare = MakePostings(num_docs, rare_density, 1);
+    auto common = MakePostings(num_docs, common_density, 2);
+    search::CompressedPostingList compressed(common);
+
+    size_t plain_hits = 0, skip_hits = 0;
+    double plain_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        plain_hits = search::SetAnd(rare, compressed.Decode()).size();
+    });
+    double skip_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        skip_hits = search::SetAnd(rare, compressed.View()).size();
+    });
+
+    std::printf("intersect rare=%-6g common=%-6g decode+merge=%9.3f ms skip=%9.3f ms hits=%zu/%zu\n",
+                rare_density, common_density, plain_sec * 1e3, skip_sec * 1e3, plain_hits, skip_hits);
+}
+
+// Every container pairing for the same two lists
+void BenchContainers(size_t num_docs, double density_a, double density_b) {
+    auto a = MakePostings(num_docs, density_a, 3);
+    auto b = MakePostings(num_docs, density_b, 4);
+    auto a_bitmap = search::ToBitmap(a);
+    auto b_bitmap = search::ToBitmap(b);
+
+    size_t array_hits = 0, mixed_hits = 0, bitmap_hits = 0;
+    double array_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        array_hits = search::SetAnd(a, b).size();
+    });
+    double mixed_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        mixed_hits = search::SetAnd(a, b_bitmap.View()).size();
+    });
+    double bitmap_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        bitmap_hits = search::CountAnd(a_bitmap.View(), b_bitmap.View());
+    });
+
+    std::printf("and       a=%-6g b=%-6g array^array=%9.3f ms array^bitmap=%9.3f ms "
+                "bitmap^bitmap=%9.3f ms hits=%zu/%zu/%zu\n",
+                density_a, density_b, array_sec * 1e3, mixed_sec * 1e3, bitmap_sec * 1e3,
+                array_hits, mixed_hits, bitmap_hits);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    size_t num_docs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : kDefaultNumDocs;
+
+    for (double density : kDensities) {
+        BenchDecode(num_docs, density);
+    }
+    for (double density : kDensities) {
+        BenchIntersect(num_docs, 0.001, density);
+    }
+    for (double density : kDensities) {
+        BenchContainers(num_docs, 0.1, density);
+    }
+    return 0;
+}
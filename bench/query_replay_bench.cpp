@@ -0,0 +1,161 @@
+// Replays a query log against the evaluator the way POST /search runs it:
+// ParseQueryRu through a shared stem cache, then EvaluateQuery on a snapshot
+// for one page of boolean and of ranked results. Closed loop, one query at a
+// time per thread; reports QPS and p50/p99/p999 latency.
+//
+// Usage: query_replay_bench [--json <path>] [query_log] [doc_count|corpus_file|segment_file] [threads] [passes]
+//   Without a log, or with "synthetic", queries over the synthetic
+//   vocabulary (bench/fixture_corpus.hpp). Unless a segment file is given the
+//   index is built in memory, with positions, from that many synthetic
+//   documents (default 20000) or the corpus file. By default the log is
+//   replayed until 20000 queries ran, so p999 rests on enough of them.
+
+#include "bench_util.hpp"
+#include "fixture_corpus.hpp"
+#include "indexing/indexer.hpp"
+#include "search/boolean_search.hpp"
+#include "search/index_snapshot.hpp"
+#include "text_processing/stem_cache.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t kSyntheticQueries = 2000;
+constexpr size_t kDefaultSyntheticDocs = 20000;
+constexpr size_t kDefaultThreads = 1;
+constexpr size_t kDefaultReplayedQueries = 20000;
+constexpr size_t kPageSize = 20;
+
+bool IsCount(const char* arg) {
+    return *arg && std::all_of(arg, arg + std::strlen(arg), [](unsigned char c) { return std::isdigit(c); });
+}
+
+std::shared_ptr<const search::IndexSnapshot> LoadSnapshot(const char* arg) {
+    if (arg && !IsCount(arg)) {
+        if (std::shared_ptr<const search::IndexSegment> segment = search::IndexSegment::Open(arg)) {
+            std::vector<search::SnapshotSegment> segments;
+            segments.push_back({segment, 0, {}});
+            return std::make_shared<const search::IndexSnapshot>(std::move(segments));
+        }
+    }
+    auto corpus = !arg ? bench::FixtureCorpus::Synthetic(kDefaultSyntheticDocs)
+                : IsCount(arg) ? bench::FixtureCorpus::Synthetic(std::strtoull(arg, nullptr, 10))
+                               : bench::FixtureCorpus::Load(arg);
+    if (corpus.Documents().empty()) {
+        return nullptr;
+    }
+    indexing::IndexerOptions options;
+    options.num_threads = 0;
+    options.positions = true;
+    indexing::Indexer indexer(corpus, options);
+    indexer.BuildIndex();
+    return indexer.Snapshot();
+}
+
+struct ReplayResult {
+    std::vector<double> latencies;
+    double seconds = 0;
+    size_t matched_queries = 0; // in one pass
+};
+
+ReplayResult Replay(const std::vector<std::string>& queries, const search::IndexSnapshot& snapshot,
+                    const search::SearchOptions& options, size_t num_threads, size_t passes) {
+    text_processing::SharedStemCache stem_cache;
+    auto run = [&](const std::string& query) {
+        auto parsed = search::ParseQueryRu(query, snapshot.Stemmer(), &stem_cache);
+        return search::EvaluateQuery(*parsed, snapshot, options).count;
+    };
+
+    // One unmeasured pass warms the caches, and counts the queries with matches
+    ReplayResult result;
+    for (const auto& query : queries) {
+        result.matched_queries += run(query) > 0;
+    }
+
+    std::vector<std::vector<double>> latencies(num_threads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            // Threads start at different places in the log
+            size_t first = t * queries.size() / num_threads;
+            latencies[t].reserve(passes * queries.size());
+            for (size_t i = 0; i < passes * queries.size(); ++i) {
+                auto query_start = std::chrono::steady_clock::now();
+                run(queries[(first + i) % queries.size()]);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - query_start;
+                latencies[t].push_back(elapsed.count());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    for (const auto& thread_latencies : latencies) {
+        result.latencies.insert(result.latencies.end(), thread_latencies.begin(), thread_latencies.end());
+    }
+    return result;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    auto json_path = bench::TakeJsonPath(argc, argv);
+    bool synthetic_queries = argc < 2 || std::strcmp(argv[1], "synthetic") == 0;
+    auto queries = synthetic_queries ? bench::SyntheticQueries(kSyntheticQueries) : bench::LoadQueryLog(argv[1]);
+    if (queries.empty()) {
+        std::fprintf(stderr, "no queries\n");
+        return 1;
+    }
+    auto snapshot = LoadSnapshot(argc > 2 ? argv[2] : nullptr);
+    if (!snapshot) {
+        std::fprintf(stderr, "no index\n");
+        return 1;
+    }
+    size_t num_threads = std::max<size_t>(1, argc > 3 ? std::strtoull(argv[3], nullptr, 10) : kDefaultThreads);
+    size_t passes = std::max<size_t>(1, argc > 4 ? std::strtoull(argv[4], nullptr, 10)
+                                                 : (kDefaultReplayedQueries + queries.size() - 1) / queries.size());
+    std::printf("queries=%zu docs=%zu threads=%zu passes=%zu\n", queries.size(), snapshot->DocCount(), num_threads,
+                passes);
+
+    bench::JsonReport report("query_replay_bench");
+    report.Context()["query_log"] = synthetic_queries ? "synthetic" : argv[1];
+    report.Context()["queries"] = static_cast<Json::UInt64>(queries.size());
+    report.Context()["index"] = argc > 2 && !IsCount(argv[2]) ? argv[2] : "synthetic";
+    report.Context()["docs"] = static_cast<Json::UInt64>(snapshot->DocCount());
+    report.Context()["stemmer"] = text_processing::StemmerName(snapshot->Stemmer());
+    report.Context()["threads"] = static_cast<Json::UInt64>(num_threads);
+    report.Context()["passes"] = static_cast<Json::UInt64>(passes);
+    report.Context()["page_size"] = static_cast<Json::UInt64>(kPageSize);
+
+    for (bool ranked : {false, true}) {
+        search::SearchOptions options;
+        options.max_docs = kPageSize;
+        options.ranked = ranked;
+        auto replay = Replay(queries, *snapshot, options, num_threads, passes);
+        auto summary = bench::Summarize(replay.latencies);
+        double qps = summary.count / replay.seconds;
+
+        const char* name = ranked ? "ranked" : "boolean";
+        std::printf("%-8s qps=%9.0f p50=%8.3f ms p99=%8.3f ms p999=%8.3f ms max=%8.3f ms matched=%zu/%zu\n", name,
+                    qps, summary.p50 * 1e3, summary.p99 * 1e3, summary.p999 * 1e3, summary.max * 1e3,
+                    replay.matched_queries, queries.size());
+
+        auto& result = report.Add(name);
+        result["qps"] = qps;
+        bench::AddLatencies(result, summary);
+        result["matched_queries"] = static_cast<Json::UInt64>(replay.matched_queries);
+    }
+    return report.Write(json_path) ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// Top-k BM25 over disjunctions of frequent terms: exhaustive scoring of every
+// match against Block-Max WAND.
+//
+// Usage: ranking_bench <segment_file> [k]
+
+#include "bench_util.hpp"
+#include "search/index_segment.hpp"
+#include "search/query_planner.hpp"
+#include "search/ranking.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr size_t kDefaultTopK = 10;
+constexpr size_t kQueriesPerWidth = 8;
+constexpr size_t kWidths[] = {1, 2, 3, 5, 8};
+constexpr int kRepetitions = 10;
+
+search::PlanNodePtr Disjunction(const search::IndexSegment& segment, const std::vector<size_t>& terms) {
+    auto plan = std::make_unique<search::PlanNode>();
+    plan->op = search::PlanOp::kOr;
+    for (size_t term : terms) {
+        auto leaf = std::make_unique<search::PlanNode>();
+        leaf->op = search::PlanOp::kTerm;
+        leaf->term = segment.Term(term);
+        leaf->postings = segment.Postings(term);
+        leaf->estimate = leaf->postings.doc_count;
+        plan->estimate += leaf->estimate;
+        plan->children.push_back(std::move(leaf));
+    }
+    return plan;
+}
+
+// Queries of the given width drawn from the most frequent terms, so every
+// one of them matches a large part of the collection
+std::vector<search::PlanNodePtr> FrequentQueries(const search::IndexSegment& segment, size_t width) {
+    std::vector<std::pair<uint32_t, size_t>> by_frequency;
+    for (size_t i = 0; i < segment.TermCount(); ++i) {
+        by_frequency.emplace_back(segment.Postings(i).doc_count, i);
+    }
+    std::sort(by_frequency.rbegin(), by_frequency.rend());
+
+    std::vector<search::PlanNodePtr> queries;
+    for (size_t q = 0; q < kQueriesPerWidth; ++q) {
+        std::vector<size_t> terms;
+        for (size_t i = 0; i < width; ++i) {
+            size_t rank = q + i * kQueriesPerWidth;
+            if (rank < by_frequency.size()) {
+                terms.push_back(by_frequency[rank].second);
+            }
+        }
+        if (terms.size() == width) {
+            queries.push_back(Disjunction(segment, terms));
+        }
+    }
+    return queries;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <segment_file> [k]\n", argv[0]);
+        return 1;
+    }
+    auto segment = search::IndexSegment::Open(argv[1]);
+    if (!segment) {
+        std::fprintf(stderr, "cannot open segment %s\n", argv[1]);
+        return 1;
+    }
+    size_t k = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : kDefaultTopK;
+
+    for (size_t width : kWidths) {
+        auto queries = FrequentQueries(*segment, width);
+        if (queries.empty()) {
+            continue;
+        }
+
+        size_t matches = 0, scored = 0;
+        double exhaustive = bench::MeasureSeconds(kRepetitions, [&] {
+            matches = 0;
+            for (const auto& plan : queries) {
+                auto it = search::BuildIterator(*plan, *segment);
+                search::Bm25Ranker ranker(*segment, *plan, k);
+                for (auto doc_id = it->Doc(); doc_id != search::kNoMoreDocs; doc_id = it->Next()) {
+                    ranker.Add(doc_id);
+                    matches++;
+                }
+                ranker.Finish();
+            }
+        });
+        double pruned = bench::MeasureSeconds(kRepetitions, [&] {
+            scored = 0;
+            for (const auto& plan : queries) {
+                scored += search::RankDisjunction(*segment, *plan, k).scored;
+            }
+        });
+        std::printf("terms=%-2zu k=%-4zu exhaustive=%8.3fms (%zu scored)  bmw=%8.3fms (%zu scored)\n",
+                    width, k, exhaustive * 1e3 / queries.size(), matches / queries.size(),
+                    pruned * 1e3 / queries.size(), scored / queries.size());
+    }
+    return 0;
+}
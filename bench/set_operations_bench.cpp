@@ -0,0 +1,147 @@
+// Docid array intersection, union and difference across list-size ratios,
+// for every SetKernel and for the per-call choice of SetAnd/SetOr/SetAndNot.
+//
+// Usage: set_operations_bench [--json <path>] [segment_file]
+//   With a segment file the list pairs are postings of that index whose
+//   document frequencies are the given ratio apart, otherwise random lists.
+
+#include "bench_util.hpp"
+#include "search/index_segment.hpp"
+#include "search/set_operations.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr size_t kSyntheticNumDocs = 2000000;
+constexpr size_t kSyntheticLongSize = 200000;
+constexpr size_t kPairsPerRatio = 8;
+constexpr size_t kMinShortSize = 16;
+constexpr int kRepetitions = 20;
+constexpr size_t kRatios[] = {1, 2, 4, 16, 64, 256, 1024};
+
+using ListPair = std::pair<search::PostingList, search::PostingList>;
+
+search::PostingList RandomList(size_t num_docs, size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<search::DocID> pick(0, static_cast<search::DocID>(num_docs - 1));
+    search::PostingList list;
+    list.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        list.push_back(pick(rng));
+    }
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+    return list;
+}
+
+std::vector<ListPair> SyntheticPairs(size_t ratio) {
+    std::mt19937 rng(static_cast<uint32_t>(ratio));
+    std::vector<ListPair> pairs;
+    for (size_t i = 0; i < kPairsPerRatio; ++i) {
+        pairs.emplace_back(RandomList(kSyntheticNumDocs, kSyntheticLongSize / ratio, rng),
+                           RandomList(kSyntheticNumDocs, kSyntheticLongSize, rng));
+    }
+    return pairs;
+}
+
+// Pairs the most frequent terms with the term whose document frequency is
+// closest to 1/ratio of theirs.
+std::vector<ListPair> SegmentPairs(const search::IndexSegment& segment, size_t ratio) {
+    std::vector<std::pair<uint32_t, size_t>> by_frequency;
+    for (size_t i = 0; i < segment.TermCount(); ++i) {
+        by_frequency.emplace_back(segment.Postings(i).doc_count, i);
+    }
+    std::sort(by_frequency.begin(), by_frequency.end());
+
+    std::vector<ListPair> pairs;
+    for (size_t n = 0; n < by_frequency.size() && pairs.size() < kPairsPerRatio; ++n) {
+        const auto& [long_size, long_term] = by_frequency[by_frequency.size() - 1 - n];
+        size_t target = long_size / ratio;
+        if (target < kMinShortSize) {
+            break;
+        }
+        auto it = std::lower_bound(by_frequency.begin(), by_frequency.end(),
+                                   std::make_pair(static_cast<uint32_t>(target), size_t{0}));
+        if (it == by_frequency.end() || it->second == long_term) {
+            continue;
+        }
+        pairs.emplace_back(search::DecodePostings(segment.Postings(it->second)),
+                           search::DecodePostings(segment.Postings(long_term)));
+    }
+    return pairs;
+}
+
+const char* KernelName(search::SetKernel kernel) {
+    switch (kernel) {
+        case search::SetKernel::kMerge: return "merge";
+        case search::SetKernel::kGallop: return "gallop";
+        case search::SetKernel::kSse42: return "sse4.2";
+        case search::SetKernel::kAvx2: return "avx2";
+    }
+    return "?";
+}
+
+template <typename Op>
+void BenchOperation(bench::JsonReport& report, const char* name, size_t ratio, const std::vector<ListPair>& pairs,
+                    Op op) {
+    constexpr search::SetKernel kKernels[] = {search::SetKernel::kMerge, search::SetKernel::kGallop,
+                                              search::SetKernel::kSse42, search::SetKernel::kAvx2};
+    std::printf("%-7s ratio=%-5zu", name, ratio);
+    auto& result = report.Add(name);
+    result["ratio"] = static_cast<Json::UInt64>(ratio);
+    for (auto kernel : kKernels) {
+        if (kernel >= search::SetKernel::kSse42 && kernel > search::BestSimdKernel()) {
+            std::printf(" %s=%9s", KernelName(kernel), "n/a");
+            continue;
+        }
+        double seconds = bench::MeasureSeconds(kRepetitions, [&] {
+            for (const auto& [a, b] : pairs) op(a, b, kernel);
+        });
+        std::printf(" %s=%9.3fms", KernelName(kernel), seconds * 1e3);
+        result[std::string(KernelName(kernel)) + "_ms"] = seconds * 1e3;
+    }
+    const auto& [a, b] = pairs.front();
+    std::printf("  chosen=%s\n", KernelName(search::ChooseSetKernel(a.size(), b.size())));
+    result["chosen"] = KernelName(search::ChooseSetKernel(a.size(), b.size()));
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    auto json_path = bench::TakeJsonPath(argc, argv);
+    std::unique_ptr<search::IndexSegment> segment;
+    if (argc > 1) {
+        segment = search::IndexSegment::Open(argv[1]);
+        if (!segment) {
+            std::fprintf(stderr, "cannot open segment %s\n", argv[1]);
+            return 1;
+        }
+    }
+    std::printf("best SIMD kernel: %s\n", KernelName(search::BestSimdKernel()));
+    bench::JsonReport report("set_operations_bench");
+    report.Context()["input"] = argc > 1 ? argv[1] : "synthetic";
+    report.Context()["best_simd_kernel"] = KernelName(search::BestSimdKernel());
+    report.Context()["pairs_per_ratio"] = static_cast<Json::UInt64>(kPairsPerRatio);
+    report.Context()["repetitions"] = kRepetitions;
+
+    for (size_t ratio : kRatios) {
+        auto pairs = segment ? SegmentPairs(*segment, ratio) : SyntheticPairs(ratio);
+        if (pairs.empty()) {
+            continue;
+        }
+        BenchOperation(report, "and", ratio, pairs, [](const auto& a, const auto& b, auto kernel) {
+            return search::SetAnd(a, b, kernel);
+        });
+        BenchOperation(report, "or", ratio, pairs, [](const auto& a, const auto& b, auto kernel) {
+            return search::SetOr(a, b, kernel);
+        });
+        BenchOperation(report, "and_not", ratio, pairs, [](const auto& a, const auto& b, auto kernel) {
+            return search::SetAndNot(b, a, kernel);
+        });
+    }
+    return report.Write(json_path) ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+// Stemming throughput in tokens/s: the previous linear scan over the
+// endings (bench/legacy_stemmer.hpp), the light stemmer's suffix automaton
+// and the Snowball stemmer built on the same automata.
+//
+// Usage: stemmer_bench [--json <path>] [text_file]
+//   With a file the tokens of its contents are stemmed, otherwise synthetic
+//   words with common Russian endings.
+
+#include "bench_util.hpp"
+#include "legacy_stemmer.hpp"
+#include "text_processing/stemmer.hpp"
+#include "text_processing/tokenizer.hpp"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kSyntheticTokens = 2000000;
+constexpr int kRepetitions = 5;
+
+std::vector<std::wstring> LoadTokens(const char* path) {
+    if (path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return text_processing::TokenizeRu(contents.str());
+    }
+
+    const std::wstring endings[] = {L"", L"а", L"ы", L"ой", L"ами", L"ями", L"ого", L"ий", L"ая",
+                                    L"ость", L"ение", L"ился", L"ивши", L"ают", L"ейший", L"ах"};
+    std::mt19937 rng(13);
+    std::uniform_int_distribution<int> letter(L'а', L'я');
+    std::uniform_int_distribution<size_t> ending(0, std::size(endings) - 1);
+    std::geometric_distribution<int> extra_length(0.3);
+    std::vector<std::wstring> tokens;
+    tokens.reserve(kSyntheticTokens);
+    for (size_t i = 0; i < kSyntheticTokens; ++i) {
+        std::wstring word(2 + extra_length(rng), L' ');
+        for (auto& c : word) c = static_cast<wchar_t>(letter(rng));
+        tokens.push_back(word + endings[ending(rng)]);
+    }
+    return tokens;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    auto json_path = bench::TakeJsonPath(argc, argv);
+    auto tokens = LoadTokens(argc > 1 ? argv[1] : nullptr);
+    if (tokens.empty()) {
+        std::fprintf(stderr, "no tokens\n");
+        return 1;
+    }
+    std::printf("tokens=%zu\n", tokens.size());
+
+    size_t checksum = 0;
+    double legacy_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        for (const auto& token : tokens) {
+            checksum += legacy::StemRu(token).size();
+        }
+    });
+    double light_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        for (const auto& token : tokens) {
+            checksum += text_processing::StemLengthRu(token, text_processing::Stemmer::kLight);
+        }
+    });
+    double snowball_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        for (const auto& token : tokens) {
+            checksum += text_processing::StemLengthRu(token, text_processing::Stemmer::kSnowball);
+        }
+    });
+
+    size_t mismatches = 0;
+    for (const auto& token : tokens) {
+        mismatches += legacy::StemRu(token) != text_processing::StemRu(token);
+    }
+
+    std::printf("%-10s %8.1f Mtokens/s\n", "legacy", tokens.size() / legacy_sec / 1e6);
+    std::printf("%-10s %8.1f Mtokens/s speedup=%.2fx mismatches=%zu\n", "light",
+                tokens.size() / light_sec / 1e6, legacy_sec / light_sec, mismatches);
+    std::printf("%-10s %8.1f Mtokens/s\n", "snowball", tokens.size() / snowball_sec / 1e6);
+    std::printf("checksum=%zu\n", checksum);
+
+    bench::JsonReport report("stemmer_bench");
+    report.Context()["input"] = argc > 1 ? argv[1] : "synthetic";
+    report.Context()["tokens"] = static_cast<Json::UInt64>(tokens.size());
+    report.Context()["repetitions"] = kRepetitions;
+    report.Add("legacy")["mtokens_per_sec"] = tokens.size() / legacy_sec / 1e6;
+    auto& light = report.Add("light");
+    light["mtokens_per_sec"] = tokens.size() / light_sec / 1e6;
+    light["mismatches"] = static_cast<Json::UInt64>(mismatches);
+    report.Add("snowball")["mtokens_per_sec"] = tokens.size() / snowball_sec / 1e6;
+    bool written = report.Write(json_path);
+    return mismatches == 0 && written ? 0 : 1;
+}
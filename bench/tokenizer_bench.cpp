@@ -0,0 +1,123 @@
+// Tokenizer throughput in MB/s of UTF-8 input: the previous wstring_convert
+// tokenizer (bench/legacy_tokenizer.hpp), TokenizeRu, and TokenScanner on
+// its own without collecting the tokens.
+//
+// Usage: tokenizer_bench [--json <path>] [text_file]
+//   With a file its contents are tokenized, otherwise synthetic Russian text
+//   with punctuation, digits and some Latin words.
+
+#include "bench_util.hpp"
+#include "legacy_tokenizer.hpp"
+#include "text_processing/tokenizer.hpp"
+#include "text_processing/utf8_converter.hpp"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kSyntheticWords = 2000000;
+constexpr int kRepetitions = 5;
+
+std::string LoadText(const char* path) {
+    if (path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return contents.str();
+    }
+
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> letter(L'а', L'я');
+    std::uniform_int_distribution<int> kind(0, 19);
+    std::geometric_distribution<int> extra_length(0.25);
+    std::wstring text;
+    for (size_t i = 0; i < kSyntheticWords; ++i) {
+        int k = kind(rng);
+        std::wstring word(1 + extra_length(rng), L' ');
+        for (auto& c : word) c = static_cast<wchar_t>(letter(rng));
+        if (k == 0) {
+            word = L"Wikipedia";
+        } else if (k == 1) {
+            word = std::to_wstring(i % 2024);
+        } else if (k == 2) {
+            word[0] = static_cast<wchar_t>(word[0] - (L'а' - L'А'));
+        } else if (k == 3) {
+            word += L'ё';
+        }
+        text += word;
+        text += k == 4 ? L", " : k == 5 ? L". " : L" ";
+    }
+    return text_processing::WstringToUtf8(text);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    auto json_path = bench::TakeJsonPath(argc, argv);
+    std::string text = LoadText(argc > 1 ? argv[1] : nullptr);
+    if (text.empty()) {
+        std::fprintf(stderr, "no input text\n");
+        return 1;
+    }
+    double megabytes = text.size() / 1e6;
+    std::printf("input=%.1f MB\n", megabytes);
+
+    size_t legacy_tokens = 0;
+    double legacy_sec = 0;
+    try {
+        legacy_sec = bench::MeasureSeconds(kRepetitions, [&] {
+            legacy_tokens = legacy::TokenizeRu(text).size();
+        });
+    } catch (const std::range_error&) {
+        std::printf("%-14s rejects malformed UTF-8 in the input\n", "legacy");
+    }
+
+    size_t tokens = 0;
+    double tokenize_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        tokens = text_processing::TokenizeRu(text).size();
+    });
+
+    size_t scanned = 0;
+    double scan_sec = bench::MeasureSeconds(kRepetitions, [&] {
+        text_processing::TokenScanner scanner(text);
+        std::wstring_view token;
+        scanned = 0;
+        while (scanner.Next(token)) {
+            ++scanned;
+        }
+    });
+
+    if (legacy_sec > 0) {
+        std::printf("%-14s tokens=%-9zu %8.1f MB/s\n", "legacy", legacy_tokens, megabytes / legacy_sec);
+    }
+    std::printf("%-14s tokens=%-9zu %8.1f MB/s", "TokenizeRu", tokens, megabytes / tokenize_sec);
+    if (legacy_sec > 0) {
+        std::printf(" speedup=%.2fx", legacy_sec / tokenize_sec);
+    }
+    std::printf("\n%-14s tokens=%-9zu %8.1f MB/s", "TokenScanner", scanned, megabytes / scan_sec);
+    if (legacy_sec > 0) {
+        std::printf(" speedup=%.2fx", legacy_sec / scan_sec);
+    }
+    std::printf("\n");
+
+    bench::JsonReport report("tokenizer_bench");
+    report.Context()["input"] = argc > 1 ? argv[1] : "synthetic";
+    report.Context()["input_mb"] = megabytes;
+    report.Context()["repetitions"] = kRepetitions;
+    auto add = [&](const char* name, size_t count, double seconds) {
+        auto& result = report.Add(name);
+        result["tokens"] = static_cast<Json::UInt64>(count);
+        result["mb_per_sec"] = megabytes / seconds;
+    };
+    if (legacy_sec > 0) {
+        add("legacy", legacy_tokens, legacy_sec);
+    }
+    add("TokenizeRu", tokens, tokenize_sec);
+    add("TokenScanner", scanned, scan_sec);
+    return report.Write(json_path) ? 0 : 1;
+}
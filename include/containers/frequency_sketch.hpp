@@ -0,0 +1,61 @@
+#ifndef CONTAINERS_FREQUENCY_SKETCH_HPP
+#define CONTAINERS_FREQUENCY_SKETCH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace containers {
+
+// Count-min sketch of small saturating counters, the popularity estimate
+// behind TinyLFU admission. Every kRows counters of a key are bumped on
+// Record and the smallest one is its estimate. After sample_size records
+// all counters are halved, so popularity that is no longer renewed fades.
+// Not thread-safe.
+class FrequencySketch {
+private:
+    static constexpr size_t kRows = 4;
+    static constexpr uint8_t kMaxCount = 15;
+    static constexpr uint64_t kRowSeeds[kRows] = {0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL,
+                                                  0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL};
+
+    std::vector<uint8_t> counters_; // kRows rows of width_ counters
+    size_t width_;
+    size_t sample_size_;
+    size_t records_ = 0;
+
+    size_t Slot(uint64_t hash, size_t row) const {
+        return row * width_ + static_cast<size_t>((hash * kRowSeeds[row]) >> 32) % width_;
+    }
+
+public:
+    // Sized for about expected_keys distinct keys
+    explicit FrequencySketch(size_t expected_keys)
+        : width_(std::max<size_t>(16, expected_keys)), sample_size_(10 * width_) {
+        counters_.assign(kRows * width_, 0);
+    }
+
+    void Record(uint64_t hash) {
+        for (size_t row = 0; row < kRows; ++row) {
+            uint8_t& counter = counters_[Slot(hash, row)];
+            if (counter < kMaxCount) ++counter;
+        }
+        if (++records_ == sample_size_) {
+            for (auto& counter : counters_) counter /= 2;
+            records_ /= 2;
+        }
+    }
+
+    uint32_t Estimate(uint64_t hash) const {
+        uint8_t estimate = kMaxCount;
+        for (size_t row = 0; row < kRows; ++row) {
+            estimate = std::min(estimate, counters_[Slot(hash, row)]);
+        }
+        return estimate;
+    }
+};
+
+} // namespace containers
+
+#endif // CONTAINERS_FREQUENCY_SKETCH_HPP
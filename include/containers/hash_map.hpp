@@ -2,84 +2,74 @@
 #define CONTAINERS_HASH_MAP_HPP
 
 #include "hash_set.hpp"
-#include <vector>
+#include "robin_hood_table.hpp"
+#include <cstddef>
 
 namespace containers {
 
 template <typename K, typename V>
 class HashMap {
-private:
+public:
     struct Node { K key; V value; };
-    std::vector<std::vector<Node>> buckets_;
-    size_t capacity_;
-    size_t num_elements_;
-    static constexpr double kMaxLoadFactor = 1.0;
-
-    void Rehash() {
-        size_t new_capacity = capacity_ * 2 + 1;
-        std::vector<std::vector<Node>> new_buckets(new_capacity);
-        Hasher<K> hasher;
-        for (auto& bucket : buckets_) {
-            for (auto& node : bucket) {
-                new_buckets[hasher(node.key) % new_capacity].push_back(std::move(node));
-            }
-        }
-        buckets_ = std::move(new_buckets);
-        capacity_ = new_capacity;
-    }
+
+private:
+    struct KeyOf {
+        const K& operator()(const Node& node) const { return node.key; }
+    };
+
+    detail::RobinHoodTable<Node, KeyOf, Hasher<K>> table_;
 
 public:
-    HashMap(size_t cap = 1009) : capacity_(cap), num_elements_(0) {
-        buckets_.resize(capacity_);
+    HashMap(size_t cap = 0) {
+        if (cap > 0) table_.Reserve(cap);
+    }
+
+    V& operator[](const K& key) {
+        return table_.FindOrInsert(key, [&key] { return Node{key, V()}; }).value;
     }
 
-    HashMap(const HashMap& other) : buckets_(other.buckets_), capacity_(other.capacity_), num_elements_(other.num_elements_) {}
-    
-    HashMap& operator=(const HashMap& other) {
-        if (this != &other) {
-            buckets_ = other.buckets_;
-            capacity_ = other.capacity_;
-            num_elements_ = other.num_elements_;
-        }
-        return *this;
+    // Like operator[] but looked up by any Q that hashes and compares like K;
+    // make_key() is only called, to build the stored key, if it is absent.
+    template <typename Q, typename MakeKey>
+    V& FindOrInsert(const Q& key, MakeKey&& make_key) {
+        return table_.FindOrInsert(key, [&make_key] { return Node{make_key(), V()}; }).value;
     }
 
-    V& operator[](const K& key) {
-        Hasher<K> hasher;
-        size_t idx = hasher(key) % capacity_;
-        for (auto& node : buckets_[idx]) {
-            if (node.key == key) return node.value;
-        }
-        if ((double)num_elements_ / capacity_ > kMaxLoadFactor) {
-            Rehash();
-            idx = hasher(key) % capacity_; 
-        }
-        buckets_[idx].push_back({key, V()});
-        num_elements_++;
-        return buckets_[idx].back().value;
+    // Lookups never insert. Q may be any type that hashes and compares like K,
+    // e.g. std::wstring_view for std::wstring keys.
+    template <typename Q>
+    V* Find(const Q& key) {
+        Node* node = table_.Find(key);
+        return node ? &node->value : nullptr;
+    }
+
+    template <typename Q>
+    const V* Find(const Q& key) const {
+        const Node* node = table_.Find(key);
+        return node ? &node->value : nullptr;
     }
 
-    size_t Size() const { return num_elements_; }
+    template <typename Q>
+    bool Contains(const Q& key) const { return table_.Find(key) != nullptr; }
+
+    template <typename Q>
+    bool Erase(const Q& key) { return table_.Erase(key); }
+
+    void Reserve(size_t count) { table_.Reserve(count); }
+    size_t Size() const { return table_.Size(); }
 
     struct Iterator {
-        const HashMap& map;
-        size_t b_idx;
-        size_t i_idx;
-        void Advance() {
-            while (b_idx < map.capacity_ && i_idx >= map.buckets_[b_idx].size()) {
-                b_idx++; i_idx = 0;
-            }
-        }
-        bool operator!=(const Iterator& other) const { return b_idx != other.b_idx || i_idx != other.i_idx; }
-        const Node& operator*() const { return map.buckets_[b_idx][i_idx]; }
-        Iterator& operator++() { i_idx++; Advance(); return *this; }
+        const HashMap* map;
+        size_t idx;
+        bool operator!=(const Iterator& other) const { return idx != other.idx; }
+        const Node& operator*() const { return map->table_.At(idx); }
+        Iterator& operator++() { idx = map->table_.NextOccupied(idx + 1); return *this; }
     };
 
-    Iterator begin() const { Iterator it{*this, 0, 0}; it.Advance(); return it; }
-    Iterator end() const { return {*this, capacity_, 0}; }
+    Iterator begin() const { return {this, table_.NextOccupied(0)}; }
+    Iterator end() const { return {this, table_.Capacity()}; }
 };
 
 } // namespace containers
 
 #endif // CONTAINERS_HASH_MAP_HPP
-
@@ -0,0 +1,217 @@
+#ifndef CONTAINERS_ROBIN_HOOD_TABLE_HPP
+#define CONTAINERS_ROBIN_HOOD_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace containers {
+
+// FNV-1a over the elements of a string-like key; integral keys hash to
+// themselves (the table scrambles the hash before use). Any key type that
+// yields the same character sequence hashes equally, which is what makes
+// e.g. std::wstring_view lookups into a std::wstring-keyed map work.
+template <typename T>
+struct Hasher {
+    template <typename U>
+    size_t operator()(const U& key) const {
+        if constexpr (std::is_integral_v<U>) {
+            return static_cast<size_t>(key);
+        } else {
+            size_t hash = 2166136261U;
+            for (auto c : key) {
+                hash ^= static_cast<size_t>(c);
+                hash *= 16777619U;
+            }
+            return hash;
+        }
+    }
+};
+
+namespace detail {
+
+// Open-addressing table with Robin Hood linear probing. One control byte per
+// slot holds the probe distance + 1 (0 marks an empty slot). An entry never
+// sits further from its home slot than the one it displaced, so a lookup stops
+// at the first slot whose distance is smaller than its own. Capacities are
+// powers of two and the home slot comes from the top bits of a Fibonacci-
+// scrambled hash; erasing shifts the following entries back instead of
+// leaving tombstones.
+template <typename Entry, typename KeyOf, typename Hash>
+class RobinHoodTable {
+private:
+    static constexpr size_t kMinCapacity = 8;
+    static constexpr uint8_t kMaxDistance = 255;
+    static constexpr uint64_t kFibonacciMultiplier = 11400714819323198485ULL;
+    static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+    std::vector<Entry> entries_;
+    std::vector<uint8_t> dists_;
+    size_t num_elements_ = 0;
+    size_t mask_ = 0;
+    int shift_ = 64;
+
+    size_t Home(size_t hash) const {
+        return static_cast<size_t>((static_cast<uint64_t>(hash) * kFibonacciMultiplier) >> shift_);
+    }
+
+    // Load factor is capped at 7/8
+    static bool Overloaded(size_t elements, size_t capacity) {
+        return elements * 8 > capacity * 7;
+    }
+
+    void Rehash(size_t new_capacity) {
+        std::vector<Entry> old_entries(new_capacity);
+        std::vector<uint8_t> old_dists(new_capacity, 0);
+        old_entries.swap(entries_);
+        old_dists.swap(dists_);
+        mask_ = new_capacity - 1;
+        shift_ = 64;
+        for (size_t c = new_capacity; c > 1; c >>= 1) {
+            --shift_;
+        }
+        for (size_t i = 0; i < old_entries.size(); ++i) {
+            if (old_dists[i] != 0) {
+                Place(std::move(old_entries[i]));
+            }
+        }
+    }
+
+    // Inserts an entry whose key is known to be absent and returns its slot.
+    // May rehash if a probe sequence gets too long, in which case the returned
+    // slot is meaningless and the caller has to look the key up again.
+    size_t Place(Entry entry) {
+        size_t idx = Home(Hash()(KeyOf()(entry)));
+        uint8_t dist = 1;
+        size_t placed = kNotFound;
+        while (true) {
+            if (dists_[idx] == 0) {
+                entries_[idx] = std::move(entry);
+                dists_[idx] = dist;
+                return placed == kNotFound ? idx : placed;
+            }
+            if (dists_[idx] < dist) {
+                std::swap(entry, entries_[idx]);
+                std::swap(dist, dists_[idx]);
+                if (placed == kNotFound) placed = idx;
+            }
+            idx = (idx + 1) & mask_;
+            if (++dist == kMaxDistance) {
+                Rehash(Capacity() * 2);
+                Place(std::move(entry));
+                return kNotFound;
+            }
+        }
+    }
+
+    template <typename Q>
+    size_t IndexOf(const Q& key) const {
+        if (num_elements_ == 0) return kNotFound;
+        size_t idx = Home(Hash()(key));
+        for (uint8_t dist = 1; dists_[idx] >= dist; ++dist) {
+            if (dists_[idx] == dist && KeyOf()(entries_[idx]) == key) {
+                return idx;
+            }
+            idx = (idx + 1) & mask_;
+        }
+        return kNotFound;
+    }
+
+public:
+    RobinHoodTable() = default;
+    RobinHoodTable(const RobinHoodTable& other) = default;
+    RobinHoodTable& operator=(const RobinHoodTable& other) = default;
+
+    RobinHoodTable(RobinHoodTable&& other) noexcept
+        : entries_(std::move(other.entries_)), dists_(std::move(other.dists_)),
+          num_elements_(std::exchange(other.num_elements_, 0)),
+          mask_(std::exchange(other.mask_, 0)), shift_(std::exchange(other.shift_, 64)) {}
+
+    RobinHoodTable& operator=(RobinHoodTable&& other) noexcept {
+        if (this != &other) {
+            entries_ = std::move(other.entries_);
+            dists_ = std::move(other.dists_);
+            num_elements_ = std::exchange(other.num_elements_, 0);
+            mask_ = std::exchange(other.mask_, 0);
+            shift_ = std::exchange(other.shift_, 64);
+            other.entries_.clear();
+            other.dists_.clear();
+        }
+        return *this;
+    }
+
+    size_t Size() const { return num_elements_; }
+    size_t Capacity() const { return entries_.size(); }
+
+    void Reserve(size_t count) {
+        size_t capacity = Capacity() > 0 ? Capacity() : kMinCapacity;
+        while (Overloaded(count, capacity)) {
+            capacity *= 2;
+        }
+        if (capacity > Capacity()) {
+            Rehash(capacity);
+        }
+    }
+
+    template <typename Q>
+    Entry* Find(const Q& key) {
+        size_t idx = IndexOf(key);
+        return idx == kNotFound ? nullptr : &entries_[idx];
+    }
+
+    template <typename Q>
+    const Entry* Find(const Q& key) const {
+        size_t idx = IndexOf(key);
+        return idx == kNotFound ? nullptr : &entries_[idx];
+    }
+
+    // make() is only called, and must return an Entry with this key, if the
+    // key is absent.
+    template <typename Q, typename Make>
+    Entry& FindOrInsert(const Q& key, Make&& make) {
+        if (Entry* found = Find(key)) return *found;
+        if (Capacity() == 0 || Overloaded(num_elements_ + 1, Capacity())) {
+            Rehash(Capacity() > 0 ? Capacity() * 2 : kMinCapacity);
+        }
+        size_t capacity = Capacity();
+        size_t idx = Place(make());
+        num_elements_++;
+        return capacity == Capacity() ? entries_[idx] : *Find(key);
+    }
+
+    template <typename Q>
+    bool Erase(const Q& key) {
+        size_t idx = IndexOf(key);
+        if (idx == kNotFound) return false;
+        size_t next = (idx + 1) & mask_;
+        while (dists_[next] > 1) {
+            entries_[idx] = std::move(entries_[next]);
+            dists_[idx] = dists_[next] - 1;
+            idx = next;
+            next = (next + 1) & mask_;
+        }
+        entries_[idx] = Entry();
+        dists_[idx] = 0;
+        num_elements_--;
+        return true;
+    }
+
+    // Slot iteration: NextOccupied(i) is the first occupied slot >= i, or
+    // Capacity() if there is none.
+    size_t NextOccupied(size_t idx) const {
+        while (idx < dists_.size() && dists_[idx] == 0) {
+            idx++;
+        }
+        return idx;
+    }
+
+    const Entry& At(size_t idx) const { return entries_[idx]; }
+};
+
+} // namespace detail
+
+} // namespace containers
+
+#endif // CONTAINERS_ROBIN_HOOD_TABLE_HPP
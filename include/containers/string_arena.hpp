@@ -0,0 +1,48 @@
+#ifndef CONTAINERS_STRING_ARENA_HPP
+#define CONTAINERS_STRING_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace containers {
+
+// Append-only storage for strings that have to outlive the buffer they come
+// from, e.g. the keys of a map looked up with views. Strings are packed into
+// blocks that never move, so a stored view stays valid as long as the arena,
+// moves of the arena included.
+template <typename CharT>
+class StringArena {
+private:
+    static constexpr size_t kBlockChars = 16384;
+
+    std::vector<std::unique_ptr<CharT[]>> blocks_;
+    size_t used_ = 0;
+    size_t capacity_ = 0;
+    size_t total_chars_ = 0;
+
+public:
+    std::basic_string_view<CharT> Store(std::basic_string_view<CharT> str) {
+        if (str.empty()) {
+            return {};
+        }
+        if (str.size() > capacity_ - used_) {
+            capacity_ = std::max(kBlockChars, str.size());
+            blocks_.push_back(std::make_unique_for_overwrite<CharT[]>(capacity_));
+            used_ = 0;
+            total_chars_ += capacity_;
+        }
+        CharT* dest = blocks_.back().get() + used_;
+        std::copy(str.begin(), str.end(), dest);
+        used_ += str.size();
+        return {dest, str.size()};
+    }
+
+    size_t Bytes() const { return total_chars_ * sizeof(CharT); }
+};
+
+} // namespace containers
+
+#endif // CONTAINERS_STRING_ARENA_HPP
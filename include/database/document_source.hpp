@@ -0,0 +1,38 @@
+#ifndef DATABASE_DOCUMENT_SOURCE_HPP
+#define DATABASE_DOCUMENT_SOURCE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace database {
+
+struct Document {
+    std::string id;
+    std::string url;
+    std::string title;
+    int created_at;
+    int pageid;
+    std::string text;
+};
+
+// The documents the indexer reads: the Mongo collection in the server, a
+// fixture corpus in the benchmarks.
+class DocumentSource {
+public:
+    virtual ~DocumentSource() = default;
+
+    // Reads every document once and hands them to consumer in batches of up
+    // to batch_size documents.
+    virtual void StreamDocuments(size_t batch_size, const std::function<void(std::vector<Document>&&)>& consumer) = 0;
+    // The same for the documents whose created_at is at least created_at;
+    // the crawler sets it on every insert and update
+    virtual void StreamDocumentsSince(int created_at, size_t batch_size,
+                                      const std::function<void(std::vector<Document>&&)>& consumer) = 0;
+    virtual size_t CountDocuments() = 0;
+};
+
+} // namespace database
+
+#endif // DATABASE_DOCUMENT_SOURCE_HPP
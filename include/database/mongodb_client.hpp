@@ -1,8 +1,9 @@
 #ifndef DATABASE_MONGODB_CLIENT_HPP
 #define DATABASE_MONGODB_CLIENT_HPP
 
-#include "containers/hash_set.hpp"
+#include "database/document_source.hpp"
 #include <chrono>
+#include <functional>
 #include <mongocxx/v_noabi/mongocxx/client.hpp>
 #include <mongocxx/v_noabi/mongocxx/collection.hpp>
 #include <mongocxx/v_noabi/mongocxx/cursor.hpp>
@@ -11,21 +12,15 @@
 
 namespace database {
 
-struct Document {
-    std::string id;
-    std::string url;
-    std::string title;
-    int created_at;
-    int pageid;
-    std::string text;
-};
-
-class MongoDBClient {
+class MongoDBClient : public DocumentSource {
 public:
     MongoDBClient(const std::string& uri, const std::string& db_name, const std::string& collection_name);
     mongocxx::cursor FindAll();
-    std::vector<Document> FindByIds(const containers::HashSet<std::string>& ids);
-    std::vector<Document> GetAllDocuments();
+    // Reads the collection through one cursor
+    void StreamDocuments(size_t batch_size, const std::function<void(std::vector<Document>&&)>& consumer) override;
+    void StreamDocumentsSince(int created_at, size_t batch_size,
+                              const std::function<void(std::vector<Document>&&)>& consumer) override;
+    size_t CountDocuments() override;
 
 private:
     mongocxx::client client_;
@@ -1,10 +1,26 @@
 #ifndef INDEXING_INDEXER_HPP
 #define INDEXING_INDEXER_HPP
 
-#include "search/boolean_search.hpp"
-#include "database/mongodb_client.hpp"
+#include "search/index_segment.hpp"
+#include "search/index_snapshot.hpp"
+#include "indexing/segment_writer.hpp"
+#include "database/document_source.hpp"
 #include "containers/hash_map.hpp"
+#include "containers/string_arena.hpp"
+#include "text_processing/stem_cache.hpp"
+#include "text_processing/stemmer.hpp"
+#include "text_processing/tokenizer.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace indexing {
@@ -16,27 +32,131 @@ struct IndexingStats {
     size_t total_chars;
     double elapsed_seconds;
     std::vector<size_t> top_frequencies;
+    size_t threads;
+    double fetch_seconds;
+    double tokenize_seconds;
+    double merge_seconds;
+    uint64_t stem_cache_hits;   // tokens whose term id came from a worker's stem cache
+    uint64_t stem_cache_misses;
+    size_t stem_cache_bytes;    // over all workers
+};
+
+struct IndexerOptions {
+    size_t num_threads = 1;   // 0 uses one thread per hardware core
+    size_t batch_size = 500;  // documents per Mongo fetch / work item
+    size_t queue_depth = 4;   // batches buffered between fetching and indexing
+    bool positions = false;   // record token positions for phrase and NEAR queries
+    text_processing::Stemmer stemmer = text_processing::Stemmer::kLight;
+};
+
+struct IncrementalOptions {
+    std::chrono::seconds poll_interval{10};
+    size_t merge_docs = 10000; // delta documents that trigger a merge into the base
+    std::string segment_path;  // merged segments are saved here unless empty
+};
+
+struct IncrementalStats {
+    size_t polls = 0;
+    size_t documents_added = 0;    // not in the index before
+    size_t documents_replaced = 0; // newer versions of indexed documents
+    size_t merges = 0;
+    size_t delta_docs = 0;         // in the delta segment, replaced ones included
+    double last_merge_seconds = 0;
+    int32_t watermark = 0;         // newest created_at indexed
 };
 
 class Indexer {
 public:
-    Indexer(database::MongoDBClient& db_client);
+    Indexer(database::DocumentSource& source, const IndexerOptions& options = {});
+    ~Indexer();
     void BuildIndex();
+    // Maps a segment written by SaveIndex. Returns false if it is missing,
+    // of an older format, lacks positions the options ask for, was built
+    // with another stemmer or no longer matches the collection size;
+    // allow_stale accepts a segment that only lacks documents added since,
+    // for incremental indexing to catch up on.
+    bool LoadIndex(const std::string& path, bool allow_stale = false);
+    void SaveIndex(const std::string& path) const;
     IndexingStats GetStats() const;
-    search::InvertedIndex& GetIndex();
-    containers::HashMap<std::wstring, size_t>& GetTermFrequencies();
+    // The current index generation. Lock-free; a query should hold on to
+    // one snapshot from start to end.
+    std::shared_ptr<const search::IndexSnapshot> Snapshot() const;
+
+    // Polls the collection in a background thread for documents created or
+    // updated since they were indexed and indexes them into a delta segment,
+    // publishing a new snapshot after every poll that found any. Once the
+    // delta holds merge_docs documents it is merged into the base segment.
+    void StartIncremental(const IncrementalOptions& options);
+    void StopIncremental();
+    IncrementalStats GetIncrementalStats() const;
 
 private:
-    database::MongoDBClient& db_client_;
-    search::InvertedIndex index_;
-    containers::HashMap<std::wstring, size_t> term_frequencies_;
+    // What one worker accumulates for its shard of documents, by term id.
+    // A word form seen before goes through stem_cache straight to its term
+    // id; otherwise it is stemmed and the stem looked up by the view, being
+    // copied into the arena only when it is new.
+    struct PartialIndex {
+        text_processing::TokenScanner scanner;
+        text_processing::StemCache stem_cache;
+        containers::StringArena<wchar_t> terms;
+        containers::HashMap<std::wstring_view, uint32_t> term_ids;
+        std::vector<std::wstring_view> term_names;
+        std::vector<TermPostings> postings;
+        std::vector<std::pair<search::DocID, uint32_t>> doc_lengths;
+        size_t total_bytes = 0;
+        size_t total_tokens = 0;
+        size_t total_chars = 0;
+        uint64_t stem_cache_hits = 0;
+        uint64_t stem_cache_misses = 0;
+
+        uint32_t TermId(std::wstring_view stem);
+    };
+
+    // A fetched batch; its documents get consecutive ordinals from first_doc_id
+    struct DocumentBatch {
+        search::DocID first_doc_id;
+        std::vector<database::Document> documents;
+    };
+
+    database::DocumentSource& source_;
+    IndexerOptions options_;
+    PostingsMap postings_; // build-time, uncompressed
+    std::vector<DocumentRecord> documents_; // build-time, by DocID ordinal
+    std::vector<uint32_t> doc_lengths_; // build-time, tokens per DocID
+    std::shared_ptr<const search::IndexSegment> segment_; // base
+    std::atomic<std::shared_ptr<const search::IndexSnapshot>> snapshot_;
+    mutable std::mutex stats_mutex_; // stats_ and incremental_stats_ once indexing runs in the background
     IndexingStats stats_;
+    IncrementalStats incremental_stats_;
+
+    // Incremental indexing; once started only its thread touches these
+    IncrementalOptions incremental_options_;
+    std::thread incremental_thread_;
+    std::mutex incremental_mutex_;
+    std::condition_variable incremental_wakeup_;
+    bool incremental_stopping_ = false;
+    int32_t watermark_ = 0;
+    containers::HashMap<std::string, search::DocID> doc_ids_; // ObjectId -> snapshot docid of live documents
+    search::DocBitmap base_deleted_;
+    PostingsMap delta_postings_;
+    std::vector<DocumentRecord> delta_documents_;
+    std::vector<uint32_t> delta_lengths_;
+    search::DocBitmap delta_deleted_;
+    std::shared_ptr<const search::IndexSegment> delta_;
     
-    void ProcessDocument(const database::Document& doc);
+    static void ProcessDocument(const database::Document& doc, search::DocID doc_id, const IndexerOptions& options,
+                                PartialIndex& partial);
+    void MergePartial(const PartialIndex& partial);
     void CalculateTopFrequencies();
+    void FinishSegment();
+    void ResetDelta();
+    void PublishSnapshot();
+    void CatalogDocuments();
+    void RunIncremental();
+    void PollChanges();
+    void MergeDelta();
 };
 
 } // namespace indexing
 
 #endif // INDEXING_INDEXER_HPP
-
@@ -0,0 +1,59 @@
+#ifndef INDEXING_SEGMENT_WRITER_HPP
+#define INDEXING_SEGMENT_WRITER_HPP
+
+#include "containers/hash_map.hpp"
+#include "search/index_segment.hpp"
+#include "text_processing/stemmer.hpp"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace indexing {
+
+struct TermPostings {
+    search::PostingList docs;
+    std::vector<uint32_t> freqs; // occurrences of the term in docs[i]
+    // Token positions of each occurrence, freqs[i] of them for docs[i] in
+    // ascending order; empty unless the indexer records positions
+    std::vector<uint32_t> positions;
+};
+
+using PostingsMap = containers::HashMap<std::wstring, TermPostings>;
+// UTF-8 terms in byte order with their postings
+using SortedPostings = std::vector<std::pair<std::string, const TermPostings*>>;
+
+// What a segment keeps of a document to answer searches without Mongo
+struct DocumentRecord {
+    std::string id; // Mongo ObjectId
+    std::string title;
+    std::string url;
+    int32_t pageid = 0;
+    int32_t created_at = 0;
+};
+
+// Lays out a complete segment in memory; terms are stored as UTF-8, sorted.
+// documents and doc_lengths (tokens per document) are indexed by docid;
+// stemmer is the one the terms were stemmed with.
+std::vector<char> SerializeSegment(
+    const PostingsMap& postings,
+    const std::vector<DocumentRecord>& documents,
+    const std::vector<uint32_t>& doc_lengths,
+    text_processing::Stemmer stemmer,
+    const std::string& stats_blob
+);
+std::vector<char> SerializeSegment(
+    const SortedPostings& sorted_terms,
+    const std::vector<DocumentRecord>& documents,
+    const std::vector<uint32_t>& doc_lengths,
+    text_processing::Stemmer stemmer,
+    const std::string& stats_blob
+);
+
+// Writes to a temporary file next to path and renames it over path, so
+// readers never observe a partially written segment. Throws on I/O errors.
+void WriteSegmentFile(const std::string& path, const char* data, size_t size);
+
+} // namespace indexing
+
+#endif // INDEXING_SEGMENT_WRITER_HPP
@@ -1,16 +1,61 @@
 #ifndef SEARCH_BOOLEAN_SEARCH_HPP
 #define SEARCH_BOOLEAN_SEARCH_HPP
 
-#include "containers/hash_map.hpp"
-#include "containers/hash_set.hpp"
+#include "search/index_segment.hpp"
+#include "search/index_snapshot.hpp"
+#include "search/query_ast.hpp"
+#include "search/query_planner.hpp"
 #include "search/set_operations.hpp"
+#include "text_processing/stem_cache.hpp"
+#include "text_processing/stemmer.hpp"
+#include <cstddef>
+#include <limits>
 #include <string>
+#include <vector>
 
 namespace search {
 
-using InvertedIndex = containers::HashMap<std::wstring, containers::HashSet<DocID>>;
+constexpr size_t kAllDocs = std::numeric_limits<size_t>::max();
 
-containers::HashSet<DocID> BooleanSearchRu(const std::string& query, InvertedIndex& index);
+struct SearchOptions {
+    size_t offset = 0;          // matches to skip before the returned page
+    size_t max_docs = kAllDocs; // page size
+    bool explain = false;
+    bool ranked = false; // page through the matches by BM25 instead of by docid
+};
+
+struct SearchResult {
+    size_t count = 0;   // number of matching documents
+    bool count_exact = true; // false: ranking skipped matches, count is a lower bound
+    PostingList docs;   // the requested page of them, ascending; ranked: best first
+    std::vector<double> scores; // ranked: the BM25 score of each of docs
+    PlanNodePtr plan;   // with explain: the executed plan and its cardinalities
+};
+
+// Tokenizes and stems a query and parses it; a query without terms parses
+// to kEmpty. The stemmer has to be the one of the index it is run against;
+// stem_cache, if given, memoizes its results across queries.
+QueryNodePtr ParseQueryRu(const std::string& query,
+                          text_processing::Stemmer stemmer = text_processing::Stemmer::kLight,
+                          text_processing::SharedStemCache* stem_cache = nullptr);
+
+// Counts every match but materializes only the page of max_docs docids after
+// offset; a single term never visits postings past that page. A ranked
+// disjunction of terms is evaluated with dynamic pruning instead and only
+// counts the documents it had to score. Documents in deleted never match.
+// Thread-safe: the index is never modified, so concurrent calls need no locking.
+SearchResult EvaluateQuery(const QueryNode& query, const IndexSegment& index,
+                           const SearchOptions& options = {}, const DocBitmapView& deleted = {});
+
+// The same over every segment of a snapshot, with snapshot docids. Each
+// segment is ranked with its own BM25 statistics. With explain, the plan of
+// a snapshot with several segments is an "or" over theirs.
+SearchResult EvaluateQuery(const QueryNode& query, const IndexSnapshot& snapshot,
+                           const SearchOptions& options = {});
+
+// ParseQueryRu and EvaluateQuery in one go
+SearchResult BooleanSearchRu(const std::string& query, const IndexSegment& index,
+                             const SearchOptions& options = {});
 
 } // namespace search
 
@@ -0,0 +1,123 @@
+#ifndef SEARCH_COMPRESSED_POSTING_LIST_HPP
+#define SEARCH_COMPRESSED_POSTING_LIST_HPP
+
+#include "search/set_operations.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace search {
+
+constexpr size_t kPostingBlockSize = 128;
+constexpr DocID kNoMoreDocs = std::numeric_limits<DocID>::max();
+// Docids a bitmap list covers per rank directory entry and per score bound
+constexpr size_t kBitmapBlockDocs = kBitmapRankWords * 64;
+
+// One entry per block: the last docid stored in it and where its bytes start.
+struct PostingBlockSkip {
+    DocID max_doc_id;
+    uint32_t byte_offset;
+};
+
+// Non-owning view over an encoded posting list. Docids are stored as varint
+// gaps in blocks of kPostingBlockSize; the first gap of a block is taken
+// relative to the previous block's max_doc_id (or 0 for the first block).
+// Dense lists are stored as a bitmap instead: bitmap.words is then set and
+// the block fields are empty. freqs, if present, holds a term frequency per
+// posting in docid order; a bitmap finds its postings' positions through its
+// rank directory. block_max_scores bounds the term's BM25 score in each block
+// (bitmap: each kBitmapBlockDocs docids) and max_score over the whole list.
+// positions, if present, holds the token positions of every posting in
+// docid order (see AppendPositions), and position_blocks where each run of
+// kPostingBlockSize postings starts in it.
+struct PostingListView {
+    uint32_t doc_count = 0;
+    const PostingBlockSkip* skips = nullptr;
+    uint32_t block_count = 0;
+    const uint8_t* data = nullptr;
+    uint32_t data_size = 0;
+    DocBitmapView bitmap;
+    const uint32_t* bitmap_ranks = nullptr;
+    const uint8_t* freqs = nullptr;
+    const float* block_max_scores = nullptr;
+    float max_score = 0;
+    const uint64_t* position_blocks = nullptr;
+    const uint8_t* positions = nullptr;
+};
+
+class CompressedPostingList {
+public:
+    CompressedPostingList() = default;
+    explicit CompressedPostingList(const PostingList& postings);
+
+    size_t Size() const { return doc_count_; }
+    size_t MemoryUsage() const;
+    PostingListView View() const;
+    PostingList Decode() const;
+
+private:
+    uint32_t doc_count_ = 0;
+    std::vector<PostingBlockSkip> skips_;
+    std::vector<uint8_t> data_;
+};
+
+// Forward-only cursor that decodes one block at a time. Advance() consults the
+// skip table first, so blocks whose max docid is below the target are never
+// decoded. Bitmap lists are read with BitmapIterator instead.
+class PostingListCursor {
+public:
+    explicit PostingListCursor(const PostingListView& view);
+
+    DocID Doc() const { return doc_; }
+    bool AtEnd() const { return doc_ == kNoMoreDocs; }
+    size_t Size() const { return view_.doc_count; }
+    // Position of the current docid within the list
+    uint32_t Index() const { return block_ * static_cast<uint32_t>(kPostingBlockSize) + pos_; }
+    DocID Next();
+    DocID Advance(DocID target);
+
+private:
+    PostingListView view_;
+    uint32_t block_ = 0;
+    uint32_t pos_ = 0;
+    uint32_t block_len_ = 0;
+    DocID doc_ = kNoMoreDocs;
+    DocID buffer_[kPostingBlockSize];
+
+    void DecodeBlock(uint32_t block);
+};
+
+PostingList DecodePostings(const PostingListView& view);
+
+// Intersects a materialized list with an encoded one, skipping every block
+// of b that cannot contain the next docid of a.
+PostingList SetAnd(const PostingList& a, const PostingListView& b);
+
+// Encodes the ascending positions of one posting: their count, then the
+// first position and the gaps between the rest, all as varints.
+void AppendPositions(std::vector<uint8_t>& out, const uint32_t* positions, uint32_t count);
+
+// Reads the positions of a list's postings for docids asked in
+// non-decreasing order. The list must have positions and contain every
+// docid asked for.
+class PositionCursor {
+public:
+    explicit PositionCursor(const PostingListView& view);
+
+    const std::vector<uint32_t>& Positions(DocID doc_id);
+
+private:
+    PostingListView view_;
+    std::optional<PostingListCursor> cursor_; // block lists only
+    std::vector<uint32_t> positions_;
+    // Where the posting after the last one read starts, to continue from
+    // there within the same block
+    uint32_t next_index_ = 0;
+    const uint8_t* next_ = nullptr;
+};
+
+} // namespace search
+
+#endif // SEARCH_COMPRESSED_POSTING_LIST_HPP
@@ -0,0 +1,172 @@
+#ifndef SEARCH_INDEX_SEGMENT_HPP
+#define SEARCH_INDEX_SEGMENT_HPP
+
+#include "search/compressed_posting_list.hpp"
+#include "search/term_dictionary.hpp"
+#include "text_processing/stemmer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace search {
+
+// On-disk layout, native endianness. Every section starts on an 8-byte
+// boundary so the arrays can be used in place from an mmap'ed file.
+constexpr char kSegmentMagic[8] = {'I', 'R', 'S', 'E', 'G', 'M', 'N', 'T'};
+// Also bumped when tokenization changes, as terms of an older segment would
+// not match the terms of new queries
+constexpr uint32_t kSegmentVersion = 11;
+
+// Strings stored per document, in this order, in doc_string_bytes
+enum DocStringField : uint32_t {
+    kDocIdField,
+    kDocTitleField,
+    kDocUrlField,
+    kDocStringFields
+};
+
+struct SegmentSection {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t doc_count;
+    uint64_t term_count;
+    uint64_t total_length;      // tokens over all documents
+    uint32_t stemmer;           // text_processing::Stemmer the terms were stemmed with
+    uint32_t reserved;
+    SegmentSection terms;       // SegmentTermEntry[term_count], sorted by term bytes
+    SegmentSection term_blocks; // uint32_t offsets into term_bytes, one per kTermBlockSize terms
+    SegmentSection term_bytes;  // UTF-8 terms, front coded (see FrontCodedTerms)
+    SegmentSection skips;       // PostingBlockSkip[] of all terms
+    SegmentSection postings;    // encoded blocks of all terms
+    SegmentSection bitmaps;     // uint64_t words of the terms stored as bitmaps
+    SegmentSection bitmap_ranks; // uint32_t rank directories of those bitmaps
+    SegmentSection freqs;       // uint8_t term frequency per posting, capped at 255
+    SegmentSection block_max_scores; // float BM25 bound per block of every term
+    SegmentSection positions;       // token positions of every posting; empty if not recorded
+    SegmentSection position_blocks; // uint64_t offsets into positions per block of postings
+    SegmentSection doc_string_offsets; // uint32_t[doc_count * kDocStringFields + 1]
+    SegmentSection doc_string_bytes;   // ObjectId, title and url of every document
+    SegmentSection doc_pageids;        // int32_t[doc_count]
+    SegmentSection doc_created_at;     // int32_t[doc_count]
+    SegmentSection universe;    // uint64_t bitmap of docs with at least one term
+    SegmentSection doc_lengths; // uint32_t[doc_count], tokens per document
+    SegmentSection stats;       // opaque, owned by the indexer
+};
+
+enum class PostingContainer : uint32_t {
+    kBlocks = 0,  // skips + varint blocks; data_* are bytes in postings
+    kBitmap = 1   // data_* are words in bitmaps, up to the last docid's word
+};
+
+// Entry i belongs to the i-th term of the dictionary
+struct SegmentTermEntry {
+    uint32_t doc_count;
+    uint32_t block_count;
+    uint64_t first_skip;
+    uint64_t data_offset;
+    uint64_t data_size;
+    PostingContainer container;
+    float max_score;            // BM25 bound over the whole list
+    uint64_t freq_offset;       // into freqs, postings in docid order
+    uint64_t rank_offset;       // kBitmap: into bitmap_ranks
+    uint64_t block_max_offset;  // into block_max_scores
+    uint64_t position_block_offset; // into position_blocks
+};
+
+// Draws from the process-wide counter behind IndexSegment::Generation
+uint64_t NextGeneration();
+
+struct DocumentMetadata {
+    std::string_view id; // Mongo ObjectId
+    std::string_view title;
+    std::string_view url;
+    int32_t pageid;
+    int32_t created_at;
+};
+
+// Immutable, read-only index. The bytes either live in a heap buffer (fresh
+// build) or in a read-only shared mapping of a segment file, so opening a
+// segment costs a validation of the header and nothing else. All accessors
+// are const and lock-free; a mapped segment is even write-protected.
+class IndexSegment {
+public:
+    ~IndexSegment();
+    IndexSegment(const IndexSegment&) = delete;
+    IndexSegment& operator=(const IndexSegment&) = delete;
+
+    // Returns nullptr if the file is missing, truncated or of another version.
+    static std::unique_ptr<IndexSegment> Open(const std::string& path);
+    static std::unique_ptr<IndexSegment> FromBuffer(std::vector<char> buffer);
+
+    size_t DocCount() const { return header_->doc_count; }
+    size_t TermCount() const { return header_->term_count; }
+    std::string Term(size_t term_idx) const { return dictionary_.Term(term_idx); }
+    PostingListView Postings(size_t term_idx) const;
+    std::optional<PostingListView> Find(std::string_view term) const;
+    // Ordinals [first, last) of the terms starting with prefix
+    std::pair<size_t, size_t> PrefixRange(std::string_view prefix) const { return dictionary_.PrefixRange(prefix); }
+    std::string_view DocumentId(DocID doc_id) const { return DocString(doc_id, kDocIdField); }
+    // Everything a search response shows of a document
+    DocumentMetadata Metadata(DocID doc_id) const;
+    uint32_t DocLength(DocID doc_id) const { return doc_lengths_[doc_id]; }
+    double AverageDocLength() const;
+    // Tokens over the documents not in deleted
+    uint64_t TotalDocLength(const DocBitmapView& deleted = {}) const;
+    // Every document that contains at least one term; NOT is taken against it
+    DocBitmapView Universe() const { return universe_; }
+    std::string_view StatsBlob() const;
+    // Whether postings carry token positions, which phrase and NEAR need
+    bool HasPositions() const { return header_->positions.size > 0; }
+    // Queries have to be stemmed with it to match the terms
+    text_processing::Stemmer Stemmer() const { return static_cast<text_processing::Stemmer>(header_->stemmer); }
+
+    // Distinct for every segment opened or built by this process, so caches
+    // can tell results of a replaced index from current ones
+    uint64_t Generation() const { return generation_; }
+
+    const char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+private:
+    IndexSegment() = default;
+    bool Init();
+    std::string_view DocString(DocID doc_id, DocStringField field) const;
+
+    std::vector<char> buffer_;
+    void* mapping_ = nullptr;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    uint64_t generation_ = 0;
+
+    const SegmentHeader* header_ = nullptr;
+    const SegmentTermEntry* terms_ = nullptr;
+    TermDictionary dictionary_;
+    const PostingBlockSkip* skips_ = nullptr;
+    const uint8_t* postings_ = nullptr;
+    const uint64_t* bitmaps_ = nullptr;
+    const uint32_t* bitmap_ranks_ = nullptr;
+    const uint8_t* freqs_ = nullptr;
+    const float* block_max_scores_ = nullptr;
+    const uint8_t* positions_ = nullptr;
+    const uint64_t* position_blocks_ = nullptr;
+    const uint32_t* doc_lengths_ = nullptr;
+    const uint32_t* doc_string_offsets_ = nullptr;
+    const char* doc_string_bytes_ = nullptr;
+    const int32_t* doc_pageids_ = nullptr;
+    const int32_t* doc_created_at_ = nullptr;
+    DocBitmapView universe_;
+};
+
+} // namespace search
+
+#endif // SEARCH_INDEX_SEGMENT_HPP
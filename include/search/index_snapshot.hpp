@@ -0,0 +1,52 @@
+#ifndef SEARCH_INDEX_SNAPSHOT_HPP
+#define SEARCH_INDEX_SNAPSHOT_HPP
+
+#include "search/index_segment.hpp"
+#include "search/set_operations.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace search {
+
+struct SnapshotSegment {
+    std::shared_ptr<const IndexSegment> segment;
+    DocID first_doc = 0; // docid of the segment's document 0 in the snapshot
+    DocBitmap deleted;   // segment docids replaced by a newer version
+};
+
+// One generation of the index: segments over consecutive docid ranges,
+// oldest first, and which of their documents later segments replaced. A
+// snapshot is never modified; the indexer publishes a new one instead, so a
+// query holding a snapshot keeps a consistent view however long it runs.
+class IndexSnapshot {
+public:
+    explicit IndexSnapshot(std::vector<SnapshotSegment> segments);
+
+    const std::vector<SnapshotSegment>& Segments() const { return segments_; }
+    // Live documents, without the replaced ones
+    size_t DocCount() const { return doc_count_; }
+    // Of the live documents
+    double AverageDocLength() const {
+        return doc_count_ > 0 ? static_cast<double>(total_length_) / doc_count_ : 0.0;
+    }
+    // By snapshot docid
+    DocumentMetadata Metadata(DocID doc_id) const;
+    // The stemmer of its segments, which all share it
+    text_processing::Stemmer Stemmer() const {
+        return segments_.empty() ? text_processing::Stemmer::kLight : segments_.front().segment->Stemmer();
+    }
+    // Distinct for every snapshot, like IndexSegment::Generation
+    uint64_t Generation() const { return generation_; }
+
+private:
+    std::vector<SnapshotSegment> segments_;
+    size_t doc_count_ = 0;
+    uint64_t total_length_ = 0;
+    uint64_t generation_;
+};
+
+} // namespace search
+
+#endif // SEARCH_INDEX_SNAPSHOT_HPP
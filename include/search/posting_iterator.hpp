@@ -0,0 +1,174 @@
+#ifndef SEARCH_POSTING_ITERATOR_HPP
+#define SEARCH_POSTING_ITERATOR_HPP
+
+#include "search/compressed_posting_list.hpp"
+#include "search/set_operations.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace search {
+
+// Pull-based cursor over an ascending docid stream. An iterator is positioned
+// on its first match as soon as it is constructed; Doc() is kNoMoreDocs once
+// it is exhausted. Advance(target) moves to the first match >= target and
+// never moves backwards.
+class PostingIterator {
+public:
+    virtual ~PostingIterator() = default;
+    virtual DocID Doc() const = 0;
+    virtual DocID Next() = 0;
+    virtual DocID Advance(DocID target) = 0;
+    // Upper bound on the number of documents this iterator can produce
+    virtual size_t Cost() const = 0;
+};
+
+using PostingIteratorPtr = std::unique_ptr<PostingIterator>;
+
+class EmptyIterator : public PostingIterator {
+public:
+    DocID Doc() const override { return kNoMoreDocs; }
+    DocID Next() override { return kNoMoreDocs; }
+    DocID Advance(DocID) override { return kNoMoreDocs; }
+    size_t Cost() const override { return 0; }
+};
+
+// Reads a term's encoded postings in place.
+class TermIterator : public PostingIterator {
+public:
+    explicit TermIterator(const PostingListView& postings) : cursor_(postings) {}
+
+    DocID Doc() const override { return cursor_.Doc(); }
+    DocID Next() override { return cursor_.Next(); }
+    DocID Advance(DocID target) override { return cursor_.Advance(target); }
+    size_t Cost() const override { return cursor_.Size(); }
+
+private:
+    PostingListCursor cursor_;
+};
+
+// Iterates a materialized list it owns.
+class ListIterator : public PostingIterator {
+public:
+    explicit ListIterator(PostingList docs);
+
+    DocID Doc() const override;
+    DocID Next() override;
+    DocID Advance(DocID target) override;
+    size_t Cost() const override { return docs_.size(); }
+
+private:
+    PostingList docs_;
+    size_t pos_ = 0;
+};
+
+// Iterates the set bits of a bitmap, either in place or one it owns.
+class BitmapIterator : public PostingIterator {
+public:
+    explicit BitmapIterator(const DocBitmapView& bitmap);
+    explicit BitmapIterator(DocBitmap bitmap);
+
+    DocID Doc() const override { return doc_; }
+    DocID Next() override;
+    DocID Advance(DocID target) override;
+    size_t Cost() const override { return bitmap_.count; }
+
+private:
+    DocBitmap owned_;
+    DocBitmapView bitmap_;
+    DocID doc_ = kNoMoreDocs;
+
+    DocID Seek(DocID target);
+};
+
+// Intersection. The first child leads and the others are asked to catch up
+// with Advance(), so large lists are skipped block by block; the planner
+// passes the children rarest first.
+class AndIterator : public PostingIterator {
+public:
+    explicit AndIterator(std::vector<PostingIteratorPtr> children);
+
+    DocID Doc() const override { return doc_; }
+    DocID Next() override;
+    DocID Advance(DocID target) override;
+    size_t Cost() const override { return children_.front()->Cost(); }
+
+private:
+    std::vector<PostingIteratorPtr> children_;
+    DocID doc_;
+
+    DocID Align(DocID target);
+};
+
+// Union: the smallest current docid among the children.
+class OrIterator : public PostingIterator {
+public:
+    explicit OrIterator(std::vector<PostingIteratorPtr> children);
+
+    DocID Doc() const override { return doc_; }
+    DocID Next() override;
+    DocID Advance(DocID target) override;
+    size_t Cost() const override { return cost_; }
+
+private:
+    std::vector<PostingIteratorPtr> children_;
+    DocID doc_;
+    size_t cost_ = 0;
+
+    DocID UpdateDoc();
+};
+
+// Documents of include that are not in exclude.
+class AndNotIterator : public PostingIterator {
+public:
+    AndNotIterator(PostingIteratorPtr include, PostingIteratorPtr exclude);
+
+    DocID Doc() const override { return include_->Doc(); }
+    DocID Next() override;
+    DocID Advance(DocID target) override;
+    size_t Cost() const override { return include_->Cost(); }
+
+private:
+    PostingIteratorPtr include_;
+    PostingIteratorPtr exclude_;
+
+    DocID SkipExcluded();
+};
+
+enum class PositionalMatch {
+    kPhrase, // the terms at consecutive positions, in order
+    kNear    // the terms in any order with at most distance other words among them
+};
+
+// Documents of candidates, an intersection of the terms, whose term
+// positions match. Positions are read only for those candidates.
+class PositionalIterator : public PostingIterator {
+public:
+    PositionalIterator(PostingIteratorPtr candidates, std::vector<PostingListView> terms,
+                       PositionalMatch match, uint32_t distance);
+
+    DocID Doc() const override { return doc_; }
+    DocID Next() override;
+    DocID Advance(DocID target) override;
+    size_t Cost() const override { return candidates_->Cost(); }
+
+private:
+    PostingIteratorPtr candidates_;
+    std::vector<PositionCursor> cursors_; // one per term, in query order
+    std::vector<const std::vector<uint32_t>*> positions_;
+    std::vector<size_t> heads_;
+    // Of each term in a NEAR, whose repeats share its cursor; 1 in a phrase
+    std::vector<size_t> copies_;
+    size_t term_count_;
+    PositionalMatch match_;
+    uint32_t distance_;
+    DocID doc_;
+
+    DocID SkipMismatches(DocID doc_id);
+    bool MatchesPhrase();
+    bool MatchesNear();
+};
+
+} // namespace search
+
+#endif // SEARCH_POSTING_ITERATOR_HPP
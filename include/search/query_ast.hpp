@@ -0,0 +1,45 @@
+#ifndef SEARCH_QUERY_AST_HPP
+#define SEARCH_QUERY_AST_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace search {
+
+enum class QueryOp {
+    kEmpty,
+    kTerm,
+    kPrefix,
+    kPhrase,
+    kNear,
+    kAnd,
+    kOr,
+    kNot
+};
+
+// Syntax tree of a boolean query as it was written. Term leaves hold the
+// stemmed term in UTF-8, ready for IndexSegment::Find; prefix leaves hold
+// the prefix as typed, unstemmed, and match every term starting with it.
+// Phrases and NEAR have term leaves as children, a phrase in the order
+// written. kEmpty stands for a malformed subexpression and matches nothing.
+struct QueryNode {
+    QueryOp op = QueryOp::kEmpty;
+    std::string term;
+    uint32_t distance = 0; // kNear: most other words among the terms
+    std::vector<std::unique_ptr<QueryNode>> children;
+
+    explicit QueryNode(QueryOp o, std::string t = "") : op(o), term(std::move(t)) {}
+};
+
+using QueryNodePtr = std::unique_ptr<QueryNode>;
+
+// A string that is equal for queries that only differ in how they were
+// written: nested AND/OR chains are flattened, their operands sorted and
+// deduplicated, and double negations cancel.
+std::string CanonicalQuery(const QueryNode& query);
+
+} // namespace search
+
+#endif // SEARCH_QUERY_AST_HPP
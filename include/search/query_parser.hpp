@@ -1,19 +1,20 @@
 #ifndef SEARCH_QUERY_PARSER_HPP
 #define SEARCH_QUERY_PARSER_HPP
 
-#include "containers/hash_map.hpp"
-#include "containers/hash_set.hpp"
+#include "search/query_ast.hpp"
+#include "text_processing/stem_cache.hpp"
+#include "text_processing/stemmer.hpp"
 #include <vector>
 #include <string>
 #include <cstddef>
 
 namespace search {
 
-using DocID = std::string;
-using InvertedIndex = containers::HashMap<std::wstring, containers::HashSet<DocID>>;
-
 enum class TokenType {
     kTerm,
+    kPrefix,      // a term followed by *
+    kQuote,
+    kNear,        // NEAR/k; value holds k
     kOperatorAnd,
     kOperatorOr,
     kOperatorNot,
@@ -29,21 +30,31 @@ struct Token {
     Token(TokenType t, const std::wstring& v = L"") : type(t), value(v) {}
 };
 
+// Holds the parse position of one query, so each query needs its own parser.
+// Parse() only builds the syntax tree; search::PlanQuery decides how it is
+// evaluated against an index.
 class QueryParser {
 public:
-    QueryParser(const std::vector<std::wstring>& tokens);
-    containers::HashSet<DocID> Parse(InvertedIndex& index);
+    // stem_cache, if given, memoizes the stemming of words
+    QueryParser(const std::vector<std::wstring>& tokens,
+                text_processing::Stemmer stemmer = text_processing::Stemmer::kLight,
+                text_processing::SharedStemCache* stem_cache = nullptr);
+    QueryNodePtr Parse();
     
 private:
     std::vector<Token> tokens_;
     size_t current_pos_;
+    text_processing::Stemmer stemmer_;
+    text_processing::SharedStemCache* stem_cache_;
     
     void Tokenize(const std::vector<std::wstring>& input_tokens);
-    containers::HashSet<DocID> ParseOrExpression(InvertedIndex& index);
-    containers::HashSet<DocID> ParseAndExpression(InvertedIndex& index);
-    containers::HashSet<DocID> ParseNotExpression(InvertedIndex& index);
-    containers::HashSet<DocID> ParseTerm(InvertedIndex& index);
-    Token CurrentToken() const;
+    QueryNodePtr ParseOrExpression();
+    QueryNodePtr ParseAndExpression();
+    QueryNodePtr ParseNotExpression();
+    QueryNodePtr ParseTerm();
+    QueryNodePtr ParsePhrase();
+    QueryNodePtr ParseNear(QueryNodePtr first);
+    const Token& CurrentToken() const;
     void Advance();
     bool Match(TokenType type);
 };
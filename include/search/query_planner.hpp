@@ -0,0 +1,57 @@
+#ifndef SEARCH_QUERY_PLANNER_HPP
+#define SEARCH_QUERY_PLANNER_HPP
+
+#include "search/index_segment.hpp"
+#include "search/posting_iterator.hpp"
+#include "search/query_ast.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace search {
+
+enum class PlanOp {
+    kEmpty,
+    kTerm,
+    kUniverse,
+    kAnd,
+    kOr,
+    kAndNot,
+    kPhrase,
+    kNear
+};
+
+struct PlanNode {
+    PlanOp op = PlanOp::kEmpty;
+    std::string term;              // kTerm
+    PostingListView postings;      // kTerm
+    size_t estimate = 0;           // upper bound on the number of matches
+    size_t matches = 0;            // filled in by CountPlanMatches
+    uint32_t distance = 0;         // kNear
+    std::vector<std::unique_ptr<PlanNode>> children; // kAndNot: include, exclude
+};
+
+using PlanNodePtr = std::unique_ptr<PlanNode>;
+
+// Turns a parsed query into an evaluation plan for one segment. Nested AND
+// and OR chains are flattened, double negations cancel, terms missing from
+// the index fold the enclosing AND to empty, and conjuncts are ordered by
+// document frequency so the rarest one leads the intersection. Negated
+// conjuncts become a difference: a && !b && !c runs as a AND NOT (b OR c),
+// and only a conjunction without a positive operand starts from the universe.
+// Phrases and NEAR keep their terms as children in the order written; on a
+// segment without positions they degrade to a plain conjunction.
+PlanNodePtr PlanQuery(const QueryNode& query, const IndexSegment& index);
+
+PostingIteratorPtr BuildIterator(const PlanNode& plan, const IndexSegment& index);
+
+// Evaluates every node of the plan on its own and records its cardinality.
+// Only meant for explaining a query: it costs a full evaluation per node.
+void CountPlanMatches(PlanNode& plan, const IndexSegment& index);
+
+const char* PlanOpName(PlanOp op);
+
+} // namespace search
+
+#endif // SEARCH_QUERY_PLANNER_HPP
@@ -0,0 +1,99 @@
+#ifndef SEARCH_RANKING_HPP
+#define SEARCH_RANKING_HPP
+
+#include "search/compressed_posting_list.hpp"
+#include "search/index_segment.hpp"
+#include "search/query_planner.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace search {
+
+constexpr double kBm25K1 = 1.2;
+constexpr double kBm25B = 0.75;
+
+double Bm25Idf(size_t doc_count, size_t doc_freq);
+// The tf and length part of a term's BM25 score; the score is idf times this
+double Bm25TermWeight(uint32_t tf, uint32_t doc_length, double average_length);
+
+// The collection BM25 scores against. A segment ranked without them uses
+// its own. The segments of a snapshot share the snapshot's, counted over its
+// live documents, so that a document scores as it would in a single merged
+// segment whichever segment holds it.
+struct Bm25Stats {
+    size_t doc_count = 0;
+    double average_length = 0;
+    // By term, for the terms of the query; a term missing counts its own list
+    std::unordered_map<std::string, size_t> doc_freqs;
+};
+
+// Documents of a posting list that are not in deleted
+size_t LiveDocFreq(const PostingListView& postings, const DocBitmapView& deleted);
+
+// Reads the stored term frequency of a posting list for docids asked in
+// non-decreasing order. Docids not in the list have frequency 0.
+class TermFrequencyCursor {
+public:
+    explicit TermFrequencyCursor(const PostingListView& view);
+
+    uint32_t Freq(DocID doc_id);
+
+private:
+    PostingListView view_;
+    std::optional<PostingListCursor> cursor_; // block lists only
+};
+
+struct ScoredDoc {
+    DocID doc_id;
+    double score;
+};
+
+// Scores matches of a plan with BM25 over its positive terms (the excluded
+// side of a difference does not contribute) and keeps the k best. Ties are
+// broken towards the lower docid, so the ranking is deterministic.
+class Bm25Ranker {
+public:
+    Bm25Ranker(const IndexSegment& index, const PlanNode& plan, size_t k, const Bm25Stats* stats = nullptr);
+
+    // Docids must be added in ascending order
+    void Add(DocID doc_id);
+    // The kept documents, best first
+    std::vector<ScoredDoc> Finish();
+
+private:
+    struct ScoredTerm {
+        TermFrequencyCursor freqs;
+        double idf;
+    };
+
+    const IndexSegment& index_;
+    std::vector<ScoredTerm> terms_;
+    double average_length_;
+    size_t k_;
+    std::vector<ScoredDoc> heap_; // worst kept document on top
+};
+
+struct PrunedRanking {
+    std::vector<ScoredDoc> hits; // best first, as Bm25Ranker would keep them
+    size_t scored = 0;           // documents scored; all matches if exact
+    bool exact = false;
+};
+
+// True for a term or a disjunction of terms, the plans RankDisjunction takes
+bool IsTermDisjunction(const PlanNode& plan);
+
+// Top-k of a disjunction by Block-Max WAND. Once k documents are kept, a
+// candidate is only scored if the stored maximum scores of its terms, first
+// over the whole lists and then over the blocks holding it, can beat the
+// k-th best; everything else is skipped without decoding or scoring.
+// Documents in deleted are never scored.
+PrunedRanking RankDisjunction(const IndexSegment& index, const PlanNode& plan, size_t k,
+                              const DocBitmapView& deleted = {}, const Bm25Stats* stats = nullptr);
+
+} // namespace search
+
+#endif // SEARCH_RANKING_HPP
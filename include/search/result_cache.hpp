@@ -0,0 +1,54 @@
+#ifndef SEARCH_RESULT_CACHE_HPP
+#define SEARCH_RESULT_CACHE_HPP
+
+#include "search/boolean_search.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace search {
+
+struct ResultCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;     // dropped to make room for a more popular result
+    uint64_t rejections = 0;    // not admitted: less popular than what it would evict
+    uint64_t invalidations = 0; // dropped because the index was replaced
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t capacity_bytes = 0;
+};
+
+// Thread-safe cache of search results. Keys are split over shards, each
+// with its own lock, LRU list and share of the memory budget. A full shard
+// admits a new result only if the frequency sketch has seen its key more
+// often than the key of the least recently used entry (TinyLFU), so a burst
+// of one-off queries cannot flush the popular ones. Every entry is tagged
+// with the generation of the segment it was computed on and is a miss for
+// any other.
+class ResultCache {
+public:
+    explicit ResultCache(size_t capacity_bytes, size_t shard_count = 16);
+    ~ResultCache();
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    std::shared_ptr<const SearchResult> Find(const std::string& key, uint64_t generation);
+    void Insert(const std::string& key, uint64_t generation, std::shared_ptr<const SearchResult> result);
+    ResultCacheStats Stats() const;
+
+private:
+    struct Shard;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t capacity_bytes_;
+
+    Shard& ShardFor(uint64_t hash);
+};
+
+} // namespace search
+
+#endif // SEARCH_RESULT_CACHE_HPP
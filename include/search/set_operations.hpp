@@ -1,50 +1,154 @@
 #ifndef SEARCH_SET_OPERATIONS_HPP
 #define SEARCH_SET_OPERATIONS_HPP
 
-#include "containers/hash_set.hpp"
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace search {
 
-using DocID = std::string;
+using DocID = uint32_t;
+using PostingList = std::vector<DocID>;
+
+// Non-owning view over a docid bitmap: bit d of words[d / 64] is set for
+// every member d. Bits past word_count are zero. count is the number of set
+// bits.
+struct DocBitmapView {
+    const uint64_t* words = nullptr;
+    uint32_t word_count = 0;
+    uint32_t count = 0;
+};
+
+struct DocBitmap {
+    std::vector<uint64_t> words;
+    uint32_t count = 0;
+
+    DocBitmapView View() const { return {words.data(), static_cast<uint32_t>(words.size()), count}; }
+};
+
+inline bool BitmapContains(const DocBitmapView& bitmap, DocID doc_id) {
+    size_t word = doc_id / 64;
+    return word < bitmap.word_count && (bitmap.words[word] >> (doc_id % 64) & 1) != 0;
+}
+
+// All operations expect strictly increasing inputs and keep the output sorted.
 
 template <typename T>
-containers::HashSet<T> SetAnd(
-    const containers::HashSet<T>& a,
-    const containers::HashSet<T>& b
+std::vector<T> SetAnd(
+    const std::vector<T>& a,
+    const std::vector<T>& b
 ) {
-    if (a.Size() > b.Size()) {
-        containers::HashSet<T> result;
-        for (const auto& x : b) {
-            if (a.Contains(x)) {
-                result.Insert(x);
-            }
+    std::vector<T> result;
+    result.reserve(a.size() < b.size() ? a.size() : b.size());
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            result.push_back(a[i]);
+            ++i;
+            ++j;
         }
-        return result;
-    } else {
-        containers::HashSet<T> result;
-        for (const auto& x : a) {
-            if (b.Contains(x)) {
-                result.Insert(x);
-            }
+    }
+    return result;
+}
+
+template <typename T>
+std::vector<T> SetOr(
+    const std::vector<T>& a,
+    const std::vector<T>& b
+) {
+    std::vector<T> result;
+    result.reserve(a.size() + b.size());
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j]) {
+            result.push_back(a[i++]);
+        } else if (b[j] < a[i]) {
+            result.push_back(b[j++]);
+        } else {
+            result.push_back(a[i]);
+            ++i;
+            ++j;
         }
-        return result;
     }
+    result.insert(result.end(), a.begin() + i, a.end());
+    result.insert(result.end(), b.begin() + j, b.end());
+    return result;
 }
 
 template <typename T>
-containers::HashSet<T> SetOr(
-    const containers::HashSet<T>& a,
-    const containers::HashSet<T>& b
+std::vector<T> SetAndNot(
+    const std::vector<T>& a,
+    const std::vector<T>& b
 ) {
-    auto result = a;
-    for (const auto& id : b) {
-        result.Insert(id);
+    std::vector<T> result;
+    result.reserve(a.size());
+    size_t i = 0, j = 0;
+    while (i < a.size()) {
+        while (j < b.size() && b[j] < a[i]) {
+            ++j;
+        }
+        if (j == b.size() || a[i] < b[j]) {
+            result.push_back(a[i]);
+        }
+        ++i;
     }
     return result;
 }
 
+// Rank directory of a bitmap: entry i counts the set bits in the words
+// before i * kBitmapRankWords.
+constexpr size_t kBitmapRankWords = 8;
+
+std::vector<uint32_t> BuildBitmapRanks(const DocBitmapView& bitmap);
+// Set bits below doc_id
+uint32_t BitmapRank(const DocBitmapView& bitmap, const uint32_t* ranks, DocID doc_id);
+
+// Kernels for docid arrays. The PostingList overloads take precedence over
+// the templates above. Each call chooses galloping when one list is at
+// least kGallopRatio times longer than the other. Otherwise it uses the
+// widest SIMD kernel the CPU supports, which is detected once at runtime.
+enum class SetKernel {
+    kMerge,   // the scalar templates above
+    kGallop,  // exponential search of the shorter list's elements in the longer
+    kSse42,
+    kAvx2
+};
+
+constexpr size_t kGallopRatio = 32;
+
+// kAvx2, kSse42 or kMerge, whichever is the best this CPU can run
+SetKernel BestSimdKernel();
+SetKernel ChooseSetKernel(size_t a_size, size_t b_size);
+
+PostingList SetAnd(const PostingList& a, const PostingList& b);
+PostingList SetOr(const PostingList& a, const PostingList& b);
+PostingList SetAndNot(const PostingList& a, const PostingList& b);
+
+// The same with a fixed kernel, for benchmarks. SIMD kernels the CPU lacks
+// fall back to kMerge.
+PostingList SetAnd(const PostingList& a, const PostingList& b, SetKernel kernel);
+PostingList SetOr(const PostingList& a, const PostingList& b, SetKernel kernel);
+PostingList SetAndNot(const PostingList& a, const PostingList& b, SetKernel kernel);
+
+// Array-bitmap kernels probe one bit per array element.
+PostingList SetAnd(const PostingList& a, const DocBitmapView& b);
+PostingList SetAndNot(const PostingList& a, const DocBitmapView& b);
+DocBitmap SetOr(const DocBitmapView& a, const PostingList& b);
+
+// Bitmap-bitmap kernels work a 64-bit word at a time and count the result
+// with popcount as they go.
+DocBitmap SetAnd(const DocBitmapView& a, const DocBitmapView& b);
+DocBitmap SetOr(const DocBitmapView& a, const DocBitmapView& b);
+DocBitmap SetAndNot(const DocBitmapView& a, const DocBitmapView& b);
+size_t CountAnd(const DocBitmapView& a, const DocBitmapView& b);
+
+DocBitmap ToBitmap(const PostingList& list);
+PostingList ToPostingList(const DocBitmapView& bitmap);
+
 } // namespace search
 
 #endif // SEARCH_SET_OPERATIONS_HPP
-
@@ -0,0 +1,25 @@
+#ifndef SEARCH_SET_OPERATIONS_SIMD_HPP
+#define SEARCH_SET_OPERATIONS_SIMD_HPP
+
+#include "search/set_operations.hpp"
+#include <cstddef>
+
+// Raw x86 kernels behind the PostingList overloads in set_operations.hpp.
+// They write whole vectors, so out needs room for the result plus
+// kSimdSlack elements, and they return the result length. Callers must check
+// that the CPU supports the instruction set first.
+namespace search::simd {
+
+constexpr size_t kSimdSlack = 8;
+
+size_t AndSse42(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out);
+size_t OrSse42(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out);
+size_t AndNotSse42(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out);
+
+size_t AndAvx2(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out);
+size_t OrAvx2(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out);
+size_t AndNotAvx2(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out);
+
+} // namespace search::simd
+
+#endif // SEARCH_SET_OPERATIONS_SIMD_HPP
@@ -0,0 +1,63 @@
+#ifndef SEARCH_TERM_DICTIONARY_HPP
+#define SEARCH_TERM_DICTIONARY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace search {
+
+// Terms per front-coded block. A lookup binary searches the first terms of
+// the blocks and then decodes at most one block.
+constexpr size_t kTermBlockSize = 16;
+
+// Sorted terms, front coded in blocks of kTermBlockSize. The first term of a
+// block is stored whole as varint length + bytes; every other one as varint
+// length of the prefix it shares with its predecessor, varint suffix length
+// and the suffix bytes.
+struct FrontCodedTerms {
+    std::vector<uint32_t> block_offsets; // into bytes, one per block
+    std::vector<uint8_t> bytes;
+};
+
+FrontCodedTerms FrontCodeTerms(const std::vector<std::string_view>& sorted_terms);
+
+// Read-only view of front-coded terms, e.g. in a mapped segment. Term
+// ordinals are the positions in the sorted order, so a prefix is a
+// contiguous range of them.
+class TermDictionary {
+public:
+    TermDictionary() = default;
+    TermDictionary(const uint32_t* block_offsets, const uint8_t* bytes, size_t term_count)
+        : block_offsets_(block_offsets), bytes_(bytes), term_count_(term_count) {}
+
+    size_t Size() const { return term_count_; }
+    std::string Term(size_t term_idx) const;
+    std::optional<size_t> Find(std::string_view term) const;
+    // Ordinal of the first term not less than term, Size() if there is none
+    size_t LowerBound(std::string_view term) const;
+    // Ordinals [first, last) of the terms starting with prefix
+    std::pair<size_t, size_t> PrefixRange(std::string_view prefix) const;
+
+private:
+    size_t BlockCount() const { return (term_count_ + kTermBlockSize - 1) / kTermBlockSize; }
+    std::string_view FirstTerm(size_t block) const;
+    // Number of blocks whose first term is not greater than term; the lower
+    // bound of term lies in the last of them
+    size_t BlocksUpTo(std::string_view term) const;
+    // Decodes the block up to the first term not less than term; returns its
+    // ordinal and whether it is equal
+    std::pair<size_t, bool> SeekInBlock(size_t block, std::string_view term) const;
+
+    const uint32_t* block_offsets_ = nullptr;
+    const uint8_t* bytes_ = nullptr;
+    size_t term_count_ = 0;
+};
+
+} // namespace search
+
+#endif // SEARCH_TERM_DICTIONARY_HPP
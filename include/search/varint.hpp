@@ -0,0 +1,36 @@
+#ifndef SEARCH_VARINT_HPP
+#define SEARCH_VARINT_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace search {
+
+// LEB128: 7 payload bits per byte, low groups first, high bit set on every
+// byte but the last.
+constexpr uint8_t kVarintContinuation = 0x80;
+constexpr uint8_t kVarintPayloadMask = 0x7F;
+constexpr int kVarintPayloadBits = 7;
+
+inline void AppendVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= kVarintContinuation) {
+        out.push_back(static_cast<uint8_t>(value | kVarintContinuation));
+        value >>= kVarintPayloadBits;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline const uint8_t* ReadVarint(const uint8_t* in, uint32_t& value) {
+    uint32_t result = *in & kVarintPayloadMask;
+    int shift = kVarintPayloadBits;
+    while (*in++ & kVarintContinuation) {
+        result |= static_cast<uint32_t>(*in & kVarintPayloadMask) << shift;
+        shift += kVarintPayloadBits;
+    }
+    value = result;
+    return in;
+}
+
+} // namespace search
+
+#endif // SEARCH_VARINT_HPP
@@ -6,6 +6,8 @@
 
 namespace text_processing {
 
+// Lowercase words plus the tokens &&, ||, !, (, ), ", NEAR/k and word* for
+// a prefix. Inside quotes only words are kept.
 std::vector<std::wstring> TokenizeQuery(const std::string& query);
 
 } // namespace text_processing
@@ -0,0 +1,75 @@
+#ifndef TEXT_PROCESSING_STEM_CACHE_HPP
+#define TEXT_PROCESSING_STEM_CACHE_HPP
+
+#include "text_processing/stemmer.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+namespace text_processing {
+
+struct StemCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+// Bounded memo from word forms to a value derived from their stem, e.g. a
+// term id. Direct mapped: a word replaces whatever shared its slot, so the
+// memory is fixed and a lookup hashes the word once. Words longer than
+// kMaxWordLength are never cached; a cache of 0 slots caches nothing. Not
+// thread-safe.
+class StemCache {
+public:
+    static constexpr size_t kMaxWordLength = 14;
+    static constexpr size_t kDefaultSlots = 4096;
+
+    // slots is rounded up to a power of two
+    explicit StemCache(size_t slots = kDefaultSlots);
+
+    const uint32_t* Find(std::wstring_view word) const;
+    void Insert(std::wstring_view word, uint32_t value);
+    size_t Entries() const { return entries_; }
+    size_t Bytes() const { return slots_.size() * sizeof(Slot); }
+
+private:
+    // One cache line
+    struct alignas(64) Slot {
+        wchar_t word[kMaxWordLength];
+        uint32_t length = 0; // 0 marks an empty slot
+        uint32_t value = 0;
+    };
+
+    size_t SlotIndex(std::wstring_view word) const;
+
+    std::vector<Slot> slots_;
+    size_t entries_ = 0;
+};
+
+// StemLengthRu behind a StemCache that threads share, e.g. for parsing
+// queries. Lookups only take a shared lock; a miss stems the word and then
+// takes the exclusive lock to cache it.
+class SharedStemCache {
+public:
+    explicit SharedStemCache(size_t slots = StemCache::kDefaultSlots) : cache_(slots) {}
+
+    // Words are only cached for the first stemmer seen
+    size_t StemLength(std::wstring_view word, Stemmer stemmer);
+    StemCacheStats Stats() const;
+
+private:
+    mutable std::shared_mutex mutex_;
+    StemCache cache_;
+    Stemmer stemmer_ = Stemmer::kLight;
+    bool bound_ = false;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+} // namespace text_processing
+
+#endif // TEXT_PROCESSING_STEM_CACHE_HPP
@@ -1,13 +1,29 @@
 #ifndef TEXT_PROCESSING_STEMMER_HPP
 #define TEXT_PROCESSING_STEMMER_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 
 namespace text_processing {
 
-std::wstring StemRu(const std::wstring& word);
+// An index and the queries against it have to use the same stemmer, so the
+// segment records which one built it.
+enum class Stemmer : uint32_t {
+    kLight = 0,    // strips one of a few noun and adjective endings
+    kSnowball = 1  // the Snowball Russian algorithm
+};
+
+const char* StemmerName(Stemmer stemmer);
+std::optional<Stemmer> ParseStemmer(std::string_view name);
+
+// Length of the stem, which is always a prefix of the word. The word is
+// expected lowercase with ё folded, as TokenScanner yields it.
+size_t StemLengthRu(std::wstring_view word, Stemmer stemmer = Stemmer::kLight);
+std::wstring StemRu(const std::wstring& word, Stemmer stemmer = Stemmer::kLight);
 
 } // namespace text_processing
 
 #endif // TEXT_PROCESSING_STEMMER_HPP
-
@@ -0,0 +1,88 @@
+#ifndef TEXT_PROCESSING_SUFFIX_AUTOMATON_HPP
+#define TEXT_PROCESSING_SUFFIX_AUTOMATON_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace text_processing {
+
+// Nodes a SuffixAutomaton over these endings needs at most
+template <size_t kEndings>
+constexpr size_t SuffixAutomatonNodes(const std::array<std::wstring_view, kEndings>& endings) {
+    size_t nodes = 1;
+    for (auto ending : endings) {
+        nodes += ending.size();
+    }
+    return nodes;
+}
+
+// Reversed trie over a fixed set of lowercase Russian word endings, meant to
+// be built at compile time. Longest() finds the longest ending of a word in
+// one backward pass over it, however many endings the set has.
+template <size_t kNodes>
+class SuffixAutomaton {
+public:
+    static constexpr int kNoEnding = -1;
+
+    struct Match {
+        size_t length = 0;      // 0 if no ending matches
+        int ending = kNoEnding; // index into the list the automaton was built from
+    };
+
+    // Endings may only use the letters а..я; anything else does not compile
+    template <size_t kEndings>
+    constexpr explicit SuffixAutomaton(const std::array<std::wstring_view, kEndings>& endings) {
+        ending_.fill(kNoEnding);
+        size_t used = 1;
+        for (size_t i = 0; i < kEndings; ++i) {
+            size_t node = 0;
+            for (size_t j = endings[i].size(); j > 0; --j) {
+                size_t letter = LetterIndex(endings[i][j - 1]);
+                if (letter >= kAlphabetSize) {
+                    throw "ending outside а..я";
+                }
+                if (next_[node][letter] == 0) {
+                    next_[node][letter] = static_cast<uint16_t>(used++);
+                }
+                node = next_[node][letter];
+            }
+            ending_[node] = static_cast<int16_t>(i);
+        }
+    }
+
+    // The longest ending of word that starts at or after min_start
+    constexpr Match Longest(std::wstring_view word, size_t min_start = 0) const {
+        Match match;
+        size_t node = 0;
+        for (size_t i = word.size(); i > min_start; --i) {
+            size_t letter = LetterIndex(word[i - 1]);
+            if (letter >= kAlphabetSize || next_[node][letter] == 0) {
+                break;
+            }
+            node = next_[node][letter];
+            if (ending_[node] != kNoEnding) {
+                match = {word.size() - i + 1, ending_[node]};
+            }
+        }
+        return match;
+    }
+
+private:
+    static constexpr wchar_t kFirstLetter = L'а';
+    static constexpr size_t kAlphabetSize = 32;
+
+    // kAlphabetSize or more for anything but а..я
+    static constexpr size_t LetterIndex(wchar_t c) {
+        return static_cast<size_t>(static_cast<uint32_t>(c) - static_cast<uint32_t>(kFirstLetter));
+    }
+
+    // Node 0 is the root, so 0 also marks a missing transition
+    std::array<std::array<uint16_t, kAlphabetSize>, kNodes> next_{};
+    std::array<int16_t, kNodes> ending_{};
+};
+
+} // namespace text_processing
+
+#endif // TEXT_PROCESSING_SUFFIX_AUTOMATON_HPP
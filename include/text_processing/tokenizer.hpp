@@ -2,14 +2,39 @@
 #define TEXT_PROCESSING_TOKENIZER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace text_processing {
 
 bool IsRussianLetter(wchar_t c);
+// Lowercase form of a Russian letter with ё folded into е, 0 for any other
+// character
+wchar_t FoldRussianLetter(wchar_t c);
+
+// Splits UTF-8 text into Russian words, folded as by FoldRussianLetter, by
+// decoding the bytes as it goes. Every other character, and any malformed
+// byte, separates words. A token stays valid until the next call to Next or
+// Reset. Reusing one scanner for many texts reuses its token buffer.
+class TokenScanner {
+public:
+    TokenScanner() = default;
+    explicit TokenScanner(std::string_view text) : text_(text) {}
+
+    void Reset(std::string_view text) {
+        text_ = text;
+        pos_ = 0;
+    }
+    bool Next(std::wstring_view& token);
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+    std::wstring token_;
+};
+
 std::vector<std::wstring> TokenizeRu(const std::string& text);
 
 } // namespace text_processing
 
 #endif // TEXT_PROCESSING_TOKENIZER_HPP
-
@@ -2,7 +2,9 @@
 #define WEB_SERVER_HPP
 
 #include "indexing/indexer.hpp"
-#include "database/mongodb_client.hpp"
+#include "search/boolean_search.hpp"
+#include "search/result_cache.hpp"
+#include "text_processing/stem_cache.hpp"
 #include <string>
 #include <functional>
 #include <memory>
@@ -11,17 +13,19 @@ namespace web {
 
 class Server {
 public:
-    Server(indexing::Indexer& indexer, database::MongoDBClient& db_client, int port);
+    // cache_bytes is the memory budget of the query result cache
+    Server(indexing::Indexer& indexer, int port, size_t cache_bytes);
     void Start();
     void Stop();
 
 private:
     indexing::Indexer& indexer_;
-    database::MongoDBClient& db_client_;
     int port_;
     void* server_impl_; // Will be httplib::Server*
+    search::ResultCache cache_;
+    text_processing::SharedStemCache stem_cache_;
     
-    std::string HandleSearch(const std::string& query);
+    std::string HandleSearch(const std::string& query, const search::SearchOptions& options);
     std::string HandleStats();
     std::string HandleHealth();
 };
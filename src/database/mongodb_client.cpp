@@ -1,6 +1,7 @@
 #include "database/mongodb_client.hpp"
 #include <chrono>
 #include <mongocxx/v_noabi/mongocxx/instance.hpp>
+#include <mongocxx/v_noabi/mongocxx/options/find.hpp>
 #include <mongocxx/v_noabi/mongocxx/uri.hpp>
 #include <bsoncxx/builder/basic/document.hpp>
 #include <bsoncxx/builder/basic/kvp.hpp>
@@ -12,6 +13,45 @@ void EnsureMongoInstance() {
     (void)instance; // Suppress unused variable warning
 }
 
+database::Document ToDocument(const bsoncxx::document::view& doc) {
+    database::Document document{};
+    document.id = doc["_id"].get_oid().value.to_string();
+
+    if (doc["pageid"]) {
+        document.pageid = doc["pageid"].get_int32().value;
+    }
+    if (doc["text"]) {
+        document.text = std::string(doc["text"].get_string().value);
+    }
+    if (doc["title"]) {
+        document.title = std::string(doc["title"].get_string().value);
+    }
+    if (doc["url"]) {
+        document.url = std::string(doc["url"].get_string().value);
+    }
+    if (doc["created_at"]) {
+        document.created_at = doc["created_at"].get_int32().value;
+    }
+    return document;
+}
+
+void StreamBatches(mongocxx::cursor& cursor, size_t batch_size,
+                   const std::function<void(std::vector<database::Document>&&)>& consumer) {
+    std::vector<database::Document> batch;
+    batch.reserve(batch_size);
+    for (auto&& doc : cursor) {
+        batch.push_back(ToDocument(doc));
+        if (batch.size() == batch_size) {
+            consumer(std::move(batch));
+            batch = std::vector<database::Document>();
+            batch.reserve(batch_size);
+        }
+    }
+    if (!batch.empty()) {
+        consumer(std::move(batch));
+    }
+}
+
 } // anonymous namespace
 
 namespace database {
@@ -27,93 +67,30 @@ mongocxx::cursor MongoDBClient::FindAll() {
     return collection_.find({});
 }
 
-std::vector<Document> MongoDBClient::FindByIds(const containers::HashSet<std::string>& ids) {
-    std::vector<Document> results;
-    
-    try {
-        bsoncxx::builder::basic::array oid_array;
-        for (const auto& id : ids) {
-            try {
-                oid_array.append(bsoncxx::oid{id});
-            } catch (const std::exception& e) {
-                continue;
-            }
-        }
-
-        if (oid_array.view().empty()) {
-            return results;
-        }
+void MongoDBClient::StreamDocuments(size_t batch_size, const std::function<void(std::vector<Document>&&)>& consumer) {
+    mongocxx::options::find options;
+    options.batch_size(static_cast<int32_t>(batch_size));
+    auto cursor = collection_.find({}, options);
+    StreamBatches(cursor, batch_size, consumer);
+}
 
-        auto query = bsoncxx::builder::basic::make_document(
-            bsoncxx::builder::basic::kvp("_id", 
-                bsoncxx::builder::basic::make_document(
-                    bsoncxx::builder::basic::kvp("$in", oid_array)
-                )
+void MongoDBClient::StreamDocumentsSince(int created_at, size_t batch_size,
+                                         const std::function<void(std::vector<Document>&&)>& consumer) {
+    auto filter = bsoncxx::builder::basic::make_document(
+        bsoncxx::builder::basic::kvp("created_at",
+            bsoncxx::builder::basic::make_document(
+                bsoncxx::builder::basic::kvp("$gte", created_at)
             )
-        );
-
-        auto cursor = collection_.find(query.view());
-
-        for (auto&& doc : cursor) {
-            Document result;
-
-            result.id = doc["_id"].get_oid().value.to_string();
-            
-            if (doc["pageid"]) {
-                result.pageid = doc["pageid"].get_int32().value;
-            }
-            if (doc["text"]) {
-                result.text = std::string(doc["text"].get_string().value);
-            }
-            if (doc["title"]) {
-                result.title = std::string(doc["title"].get_string().value);
-            }
-            if (doc["url"]) {
-                result.url = std::string(doc["url"].get_string().value);
-            }
-            if (doc["created_at"]) {
-                result.created_at = doc["created_at"].get_int32().value;;
-            }
-            
-            results.push_back(std::move(result));
-        }
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Error in FindByIds: " << e.what() << std::endl;
-    }
-    
-    return results;
+        )
+    );
+    mongocxx::options::find options;
+    options.batch_size(static_cast<int32_t>(batch_size));
+    auto cursor = collection_.find(filter.view(), options);
+    StreamBatches(cursor, batch_size, consumer);
 }
 
-std::vector<Document> MongoDBClient::GetAllDocuments() {
-    std::vector<Document> documents;
-    auto cursor = FindAll();
-    
-    for (auto&& doc : cursor) {
-        Document document;
-        document.id = doc["_id"].get_oid().value.to_string();
-
-        if (doc["pageid"]) {
-            document.pageid = doc["pageid"].get_int32().value;
-        }
-        if (doc["text"]) {
-            document.text = std::string(doc["text"].get_string().value);
-        }
-        if (doc["title"]) {
-            document.title = std::string(doc["title"].get_string().value);
-        }
-        if (doc["url"]) {
-            document.url = std::string(doc["url"].get_string().value);
-        }
-        if (doc["created_at"]) {
-            document.created_at = doc["created_at"].get_int32().value;
-        }
-        
-        documents.push_back(document);
-    }
-    
-    return documents;
+size_t MongoDBClient::CountDocuments() {
+    return static_cast<size_t>(collection_.estimated_document_count());
 }
 
 } // namespace database
-
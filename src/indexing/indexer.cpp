@@ -1,78 +1,643 @@
 #include "indexing/indexer.hpp"
 #include "text_processing/tokenizer.hpp"
 #include "text_processing/stemmer.hpp"
+#include "containers/bounded_queue.hpp"
 #include <chrono>
 #include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <thread>
 
 namespace {
 
 constexpr size_t kTopFrequenciesCount = 10;
 
+template <typename T>
+void AppendRaw(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool ReadRaw(std::string_view& in, T& value) {
+    if (in.size() < sizeof(value)) return false;
+    std::memcpy(&value, in.data(), sizeof(value));
+    in.remove_prefix(sizeof(value));
+    return true;
+}
+
+std::string EncodeStats(const indexing::IndexingStats& stats) {
+    std::string blob;
+    AppendRaw<uint64_t>(blob, stats.docs_count);
+    AppendRaw<uint64_t>(blob, stats.total_bytes);
+    AppendRaw<uint64_t>(blob, stats.total_tokens);
+    AppendRaw<uint64_t>(blob, stats.total_chars);
+    AppendRaw<double>(blob, stats.elapsed_seconds);
+    AppendRaw<uint64_t>(blob, stats.threads);
+    AppendRaw<double>(blob, stats.fetch_seconds);
+    AppendRaw<double>(blob, stats.tokenize_seconds);
+    AppendRaw<double>(blob, stats.merge_seconds);
+    AppendRaw<uint64_t>(blob, stats.top_frequencies.size());
+    for (size_t freq : stats.top_frequencies) {
+        AppendRaw<uint64_t>(blob, freq);
+    }
+    AppendRaw<uint64_t>(blob, stats.stem_cache_hits);
+    AppendRaw<uint64_t>(blob, stats.stem_cache_misses);
+    AppendRaw<uint64_t>(blob, stats.stem_cache_bytes);
+    return blob;
+}
+
+indexing::IndexingStats DecodeStats(std::string_view blob) {
+    indexing::IndexingStats stats{};
+    uint64_t docs_count = 0, total_bytes = 0, total_tokens = 0, total_chars = 0, threads = 0, top_count = 0;
+    ReadRaw(blob, docs_count);
+    ReadRaw(blob, total_bytes);
+    ReadRaw(blob, total_tokens);
+    ReadRaw(blob, total_chars);
+    ReadRaw(blob, stats.elapsed_seconds);
+    ReadRaw(blob, threads);
+    ReadRaw(blob, stats.fetch_seconds);
+    ReadRaw(blob, stats.tokenize_seconds);
+    ReadRaw(blob, stats.merge_seconds);
+    ReadRaw(blob, top_count);
+    stats.docs_count = docs_count;
+    stats.total_bytes = total_bytes;
+    stats.total_tokens = total_tokens;
+    stats.total_chars = total_chars;
+    stats.threads = threads;
+    uint64_t freq;
+    while (top_count-- > 0 && ReadRaw(blob, freq)) {
+        stats.top_frequencies.push_back(freq);
+    }
+    uint64_t stem_cache_bytes = 0;
+    ReadRaw(blob, stats.stem_cache_hits);
+    ReadRaw(blob, stats.stem_cache_misses);
+    ReadRaw(blob, stem_cache_bytes);
+    stats.stem_cache_bytes = stem_cache_bytes;
+    return stats;
+}
+
+// Workers take batches in turn, so their docid ranges interleave
+void MergePostings(indexing::TermPostings& into, const indexing::TermPostings& from) {
+    if (into.docs.empty() || into.docs.back() < from.docs.front()) {
+        into.docs.insert(into.docs.end(), from.docs.begin(), from.docs.end());
+        into.freqs.insert(into.freqs.end(), from.freqs.begin(), from.freqs.end());
+        into.positions.insert(into.positions.end(), from.positions.begin(), from.positions.end());
+        return;
+    }
+
+    indexing::TermPostings merged;
+    merged.docs.reserve(into.docs.size() + from.docs.size());
+    merged.freqs.reserve(into.docs.size() + from.docs.size());
+    merged.positions.reserve(into.positions.size() + from.positions.size());
+    // Each posting owns the next freqs[i] positions of its list
+    auto take = [&merged](const indexing::TermPostings& list, size_t& i, size_t& position) {
+        merged.docs.push_back(list.docs[i]);
+        merged.freqs.push_back(list.freqs[i]);
+        if (!list.positions.empty()) {
+            auto begin = list.positions.begin() + position;
+            merged.positions.insert(merged.positions.end(), begin, begin + list.freqs[i]);
+            position += list.freqs[i];
+        }
+        ++i;
+    };
+    size_t i = 0, j = 0, into_position = 0, from_position = 0;
+    while (i < into.docs.size() || j < from.docs.size()) {
+        if (j == from.docs.size() || (i < into.docs.size() && into.docs[i] < from.docs[j])) {
+            take(into, i, into_position);
+        } else {
+            take(from, j, from_position);
+        }
+    }
+    into = std::move(merged);
+}
+
+void MarkDeleted(search::DocBitmap& deleted, search::DocID doc_id) {
+    if (deleted.words.size() <= doc_id / 64) {
+        deleted.words.resize(doc_id / 64 + 1, 0);
+    }
+    uint64_t bit = uint64_t{1} << (doc_id % 64);
+    if (!(deleted.words[doc_id / 64] & bit)) {
+        deleted.words[doc_id / 64] |= bit;
+        deleted.count++;
+    }
+}
+
+// Appends a term's postings of one segment under their new docids, dropping
+// the documents mapped to kNoMoreDocs. Without positions only the stored,
+// capped frequencies are left.
+void AppendLivePostings(const search::IndexSegment& segment, size_t term_idx,
+                        const std::vector<search::DocID>& new_ids, indexing::TermPostings& into) {
+    auto view = segment.Postings(term_idx);
+    auto docs = search::DecodePostings(view);
+    std::optional<search::PositionCursor> positions;
+    if (segment.HasPositions()) {
+        positions.emplace(view);
+    }
+    for (size_t i = 0; i < docs.size(); ++i) {
+        search::DocID new_id = new_ids[docs[i]];
+        if (new_id == search::kNoMoreDocs) {
+            continue;
+        }
+        into.docs.push_back(new_id);
+        if (positions) {
+            const auto& doc_positions = positions->Positions(docs[i]);
+            into.freqs.push_back(static_cast<uint32_t>(doc_positions.size()));
+            into.positions.insert(into.positions.end(), doc_positions.begin(), doc_positions.end());
+        } else {
+            into.freqs.push_back(view.freqs[i]);
+        }
+    }
+}
+
+size_t Occurrences(const indexing::TermPostings& postings) {
+    size_t total = 0;
+    for (uint32_t freq : postings.freqs) {
+        total += freq;
+    }
+    return total;
+}
+
+// The kTopFrequenciesCount largest, descending
+std::vector<size_t> TopFrequencies(std::vector<size_t> freqs) {
+    size_t count = std::min(kTopFrequenciesCount, freqs.size());
+    std::partial_sort(freqs.begin(), freqs.begin() + count, freqs.end(), std::greater<>());
+    freqs.resize(count);
+    return freqs;
+}
+
+double SecondsSince(std::chrono::high_resolution_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count();
+}
+
 } // anonymous namespace
 
 namespace indexing {
 
-Indexer::Indexer(database::MongoDBClient& db_client) : db_client_(db_client) {
+Indexer::Indexer(database::DocumentSource& source, const IndexerOptions& options)
+    : source_(source), options_(options) {
+    if (options_.num_threads == 0) {
+        options_.num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    options_.batch_size = std::max<size_t>(1, options_.batch_size);
     stats_ = {};
+    FinishSegment();
+}
+
+Indexer::~Indexer() {
+    StopIncremental();
 }
 
 void Indexer::BuildIndex() {
     stats_ = {};
+    postings_ = PostingsMap();
+    documents_.clear();
+    doc_lengths_.clear();
+    ResetDelta();
     auto start_time = std::chrono::high_resolution_clock::now();
 
-    auto documents = db_client_.GetAllDocuments();
-    
-    for (const auto& doc : documents) {
-        ProcessDocument(doc);
+    // The calling thread drains the Mongo cursor into a bounded queue while the
+    // workers index earlier batches, so only queue_depth batches of full
+    // documents are alive at a time and only their metadata survives indexing
+    containers::BoundedQueue<DocumentBatch> queue(options_.queue_depth);
+    std::vector<PartialIndex> partials(options_.num_threads);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < options_.num_threads; ++i) {
+        workers.emplace_back([&queue, &partial = partials[i], this]() {
+            while (auto batch = queue.Pop()) {
+                for (size_t j = 0; j < batch->documents.size(); ++j) {
+                    ProcessDocument(batch->documents[j], batch->first_doc_id + static_cast<search::DocID>(j),
+                                    options_, partial);
+                }
+            }
+        });
+    }
+
+    try {
+        auto fetch_start = std::chrono::high_resolution_clock::now();
+        double blocked_seconds = 0;
+        source_.StreamDocuments(options_.batch_size, [&](std::vector<database::Document>&& documents) {
+            DocumentBatch batch{static_cast<search::DocID>(documents_.size()), std::move(documents)};
+            // Workers only need the text; the rest goes straight into the segment
+            for (auto& doc : batch.documents) {
+                documents_.push_back({std::move(doc.id), std::move(doc.title), std::move(doc.url),
+                                      doc.pageid, doc.created_at});
+            }
+            auto push_start = std::chrono::high_resolution_clock::now();
+            queue.Push(std::move(batch));
+            blocked_seconds += SecondsSince(push_start);
+        });
+        stats_.fetch_seconds = SecondsSince(fetch_start) - blocked_seconds;
+    } catch (...) {
+        queue.Close();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        throw;
+    }
+
+    queue.Close();
+    for (auto& worker : workers) {
+        worker.join();
     }
+    stats_.tokenize_seconds = SecondsSince(start_time);
 
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed = end_time - start_time;
-    stats_.elapsed_seconds = elapsed.count();
+    auto phase_start = std::chrono::high_resolution_clock::now();
+    doc_lengths_.assign(documents_.size(), 0);
+    for (const auto& partial : partials) {
+        MergePartial(partial);
+    }
+    stats_.merge_seconds = SecondsSince(phase_start);
+
+    stats_.docs_count = documents_.size();
+    stats_.threads = options_.num_threads;
+    stats_.elapsed_seconds = SecondsSince(start_time);
     
     CalculateTopFrequencies();
+    FinishSegment();
+}
+
+bool Indexer::LoadIndex(const std::string& path, bool allow_stale) {
+    auto segment = search::IndexSegment::Open(path);
+    if (!segment || (options_.positions && !segment->HasPositions()) || segment->Stemmer() != options_.stemmer) {
+        return false;
+    }
+    size_t collection_size = source_.CountDocuments();
+    if (allow_stale ? segment->DocCount() > collection_size : segment->DocCount() != collection_size) {
+        return false;
+    }
+
+    segment_ = std::move(segment);
+    ResetDelta();
+    stats_ = DecodeStats(segment_->StatsBlob());
+    PublishSnapshot();
+    return true;
+}
+
+void Indexer::SaveIndex(const std::string& path) const {
+    // segment_ belongs to the incremental thread once it runs
+    auto segment = Snapshot()->Segments().front().segment;
+    WriteSegmentFile(path, segment->Data(), segment->Size());
+}
+
+void Indexer::FinishSegment() {
+    segment_ = search::IndexSegment::FromBuffer(
+        SerializeSegment(postings_, documents_, doc_lengths_, options_.stemmer, EncodeStats(stats_)));
+    postings_ = PostingsMap();
+    documents_ = std::vector<DocumentRecord>();
+    doc_lengths_ = std::vector<uint32_t>();
+    PublishSnapshot();
+}
+
+void Indexer::ResetDelta() {
+    base_deleted_ = {};
+    delta_postings_ = PostingsMap();
+    delta_documents_.clear();
+    delta_lengths_.clear();
+    delta_deleted_ = {};
+    delta_ = nullptr;
+}
+
+void Indexer::PublishSnapshot() {
+    std::vector<search::SnapshotSegment> segments;
+    segments.push_back({segment_, 0, base_deleted_});
+    if (delta_) {
+        segments.push_back({delta_, static_cast<search::DocID>(segment_->DocCount()), delta_deleted_});
+    }
+    snapshot_.store(std::make_shared<const search::IndexSnapshot>(std::move(segments)));
 }
 
-void Indexer::ProcessDocument(const database::Document& doc) {
-    stats_.total_bytes += doc.text.size();
-    stats_.docs_count++;
+void Indexer::ProcessDocument(const database::Document& doc, search::DocID doc_id, const IndexerOptions& options,
+                              PartialIndex& partial) {
+    partial.total_bytes += doc.text.size();
 
-    auto tokens = text_processing::TokenizeRu(doc.text);
-    for (const auto& t : tokens) {
-        auto stem = text_processing::StemRu(t);
-        index_[stem].Insert(doc.id);
-        
-        term_frequencies_[stem]++;
-        stats_.total_tokens++;
-        stats_.total_chars += t.length();
+    auto& scanner = partial.scanner;
+    scanner.Reset(doc.text);
+    std::wstring_view token;
+    uint32_t position = 0;
+    for (; scanner.Next(token); ++position) {
+        uint32_t term_id;
+        if (const uint32_t* cached = partial.stem_cache.Find(token)) {
+            term_id = *cached;
+            partial.stem_cache_hits++;
+        } else {
+            term_id = partial.TermId(token.substr(0, text_processing::StemLengthRu(token, options.stemmer)));
+            partial.stem_cache.Insert(token, term_id);
+            partial.stem_cache_misses++;
+        }
+        auto& postings = partial.postings[term_id];
+        if (postings.docs.empty() || postings.docs.back() != doc_id) {
+            postings.docs.push_back(doc_id);
+            postings.freqs.push_back(0);
+        }
+        postings.freqs.back()++;
+        if (options.positions) {
+            postings.positions.push_back(position);
+        }
+
+        partial.total_tokens++;
+        partial.total_chars += token.length();
     }
+    partial.doc_lengths.emplace_back(doc_id, position);
 }
 
-void Indexer::CalculateTopFrequencies() {
-    std::vector<size_t> freqs;
-    for (const auto& node : term_frequencies_) {
-        freqs.push_back(node.value);
+uint32_t Indexer::PartialIndex::TermId(std::wstring_view stem) {
+    auto term_id = static_cast<uint32_t>(term_names.size());
+    uint32_t& found = term_ids.FindOrInsert(stem, [this, stem, term_id] {
+        term_names.push_back(terms.Store(stem));
+        postings.emplace_back();
+        return term_names.back();
+    });
+    if (term_names.size() > term_id) {
+        found = term_id;
     }
+    return found;
+}
 
-    std::sort(freqs.rbegin(), freqs.rend());
-    
-    size_t count = std::min(kTopFrequenciesCount, freqs.size());
-    if (count > 0) {
-        stats_.top_frequencies.assign(freqs.begin(), freqs.begin() + count);
+void Indexer::MergePartial(const PartialIndex& partial) {
+    for (size_t term_id = 0; term_id < partial.term_names.size(); ++term_id) {
+        auto term = partial.term_names[term_id];
+        MergePostings(postings_.FindOrInsert(term, [term] { return std::wstring(term); }), partial.postings[term_id]);
+    }
+    for (const auto& [doc_id, length] : partial.doc_lengths) {
+        doc_lengths_[doc_id] = length;
+    }
+    stats_.total_bytes += partial.total_bytes;
+    stats_.total_tokens += partial.total_tokens;
+    stats_.total_chars += partial.total_chars;
+    stats_.stem_cache_hits += partial.stem_cache_hits;
+    stats_.stem_cache_misses += partial.stem_cache_misses;
+    stats_.stem_cache_bytes += partial.stem_cache.Bytes();
+}
+
+void Indexer::CalculateTopFrequencies() {
+    // Occurrences of each term
+    std::vector<size_t> freqs;
+    freqs.reserve(postings_.Size());
+    for (const auto& node : postings_) {
+        freqs.push_back(Occurrences(node.value));
     }
+    stats_.top_frequencies = TopFrequencies(std::move(freqs));
 }
 
 IndexingStats Indexer::GetStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
     return stats_;
 }
 
-search::InvertedIndex& Indexer::GetIndex() {
-    return index_;
+std::shared_ptr<const search::IndexSnapshot> Indexer::Snapshot() const {
+    return snapshot_.load();
 }
 
-containers::HashMap<std::wstring, size_t>& Indexer::GetTermFrequencies() {
-    return term_frequencies_;
+void Indexer::StartIncremental(const IncrementalOptions& options) {
+    StopIncremental();
+    incremental_options_ = options;
+    incremental_stopping_ = false;
+    CatalogDocuments();
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        incremental_stats_.watermark = watermark_;
+    }
+    incremental_thread_ = std::thread(&Indexer::RunIncremental, this);
 }
 
-} // namespace indexing
+void Indexer::StopIncremental() {
+    if (!incremental_thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(incremental_mutex_);
+        incremental_stopping_ = true;
+    }
+    incremental_wakeup_.notify_all();
+    incremental_thread_.join();
+}
+
+IncrementalStats Indexer::GetIncrementalStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return incremental_stats_;
+}
+
+// Maps the ObjectId of every live document to its docid and finds the newest
+// created_at, from which polling continues
+void Indexer::CatalogDocuments() {
+    auto snapshot = Snapshot();
+    doc_ids_ = containers::HashMap<std::string, search::DocID>(snapshot->DocCount());
+    for (const auto& part : snapshot->Segments()) {
+        for (search::DocID doc_id = 0; doc_id < part.segment->DocCount(); ++doc_id) {
+            if (search::BitmapContains(part.deleted.View(), doc_id)) {
+                continue;
+            }
+            auto metadata = part.segment->Metadata(doc_id);
+            doc_ids_[std::string(metadata.id)] = part.first_doc + doc_id;
+            watermark_ = std::max(watermark_, metadata.created_at);
+        }
+    }
+}
 
+void Indexer::RunIncremental() {
+    std::unique_lock<std::mutex> lock(incremental_mutex_);
+    while (!incremental_wakeup_.wait_for(lock, incremental_options_.poll_interval,
+                                         [this] { return incremental_stopping_; })) {
+        lock.unlock();
+        try {
+            PollChanges();
+            if (delta_documents_.size() >= incremental_options_.merge_docs) {
+                MergeDelta();
+            }
+        } catch (const std::exception& e) {
+            // Nothing was published; the next poll starts over from the same watermark
+            std::cerr << "Incremental indexing failed: " << e.what() << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+void Indexer::PollChanges() {
+    auto snapshot = Snapshot();
+    auto base_count = static_cast<search::DocID>(segment_->DocCount());
+    auto first_new = static_cast<search::DocID>(delta_documents_.size());
+    search::DocID snapshot_end = 0; // past its last docid, replaced ones included
+    if (!snapshot->Segments().empty()) {
+        const auto& last = snapshot->Segments().back();
+        snapshot_end = last.first_doc + static_cast<search::DocID>(last.segment->DocCount());
+    }
+    // Nothing touches the published state until the stream has ended, so a
+    // poll that fails partway leaves it as it was
+    PartialIndex partial;
+    std::vector<DocumentRecord> new_documents;
+    std::vector<search::DocID> replaced_ids; // snapshot docids
+    containers::HashMap<std::string, search::DocID> polled_ids; // to new_documents
+    size_t added = 0, replaced = 0;
+    int32_t watermark = watermark_;
+    source_.StreamDocumentsSince(watermark_, options_.batch_size, [&](std::vector<database::Document>&& documents) {
+        for (auto& doc : documents) {
+            watermark = std::max(watermark, doc.created_at);
+            // A document updated while the cursor runs comes back again in the
+            // same poll; it was already counted when first seen
+            if (search::DocID* seen = polled_ids.Find(doc.id)) {
+                if (new_documents[*seen].created_at == doc.created_at) {
+                    continue;
+                }
+                replaced_ids.push_back(base_count + first_new + *seen);
+            } else if (const search::DocID* known = doc_ids_.Find(doc.id)) {
+                // Documents of the second polled last are seen again unchanged
+                if (*known < snapshot_end && snapshot->Metadata(*known).created_at == doc.created_at) {
+                    continue;
+                }
+                replaced_ids.push_back(*known);
+                replaced++;
+            } else {
+                added++;
+            }
+            auto ordinal = static_cast<search::DocID>(new_documents.size());
+            ProcessDocument(doc, first_new + ordinal, options_, partial);
+            polled_ids[doc.id] = ordinal;
+            new_documents.push_back({std::move(doc.id), std::move(doc.title), std::move(doc.url),
+                                     doc.pageid, doc.created_at});
+        }
+    });
+
+    if (added + replaced > 0) {
+        for (search::DocID doc_id : replaced_ids) {
+            if (doc_id < base_count) {
+                MarkDeleted(base_deleted_, doc_id);
+            } else {
+                MarkDeleted(delta_deleted_, doc_id - base_count);
+            }
+        }
+        for (auto& record : new_documents) {
+            doc_ids_[record.id] = base_count + static_cast<search::DocID>(delta_documents_.size());
+            delta_documents_.push_back(std::move(record));
+        }
+        for (size_t term_id = 0; term_id < partial.term_names.size(); ++term_id) {
+            auto term = partial.term_names[term_id];
+            MergePostings(delta_postings_.FindOrInsert(term, [term] { return std::wstring(term); }),
+                          partial.postings[term_id]);
+        }
+        delta_lengths_.resize(delta_documents_.size());
+        for (const auto& [doc_id, length] : partial.doc_lengths) {
+            delta_lengths_[doc_id] = length;
+        }
+        // The delta is small, so it is simply written anew
+        delta_ = search::IndexSegment::FromBuffer(
+            SerializeSegment(delta_postings_, delta_documents_, delta_lengths_, options_.stemmer, std::string()));
+        PublishSnapshot();
+    }
+    watermark_ = watermark;
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    incremental_stats_.polls++;
+    incremental_stats_.documents_added += added;
+    incremental_stats_.documents_replaced += replaced;
+    incremental_stats_.delta_docs = delta_documents_.size();
+    incremental_stats_.watermark = watermark_;
+}
+
+// Rewrites the live documents of base and delta as one segment, merging the
+// sorted term dictionaries of the two
+void Indexer::MergeDelta() {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto snapshot = Snapshot();
+    const auto& parts = snapshot->Segments();
+
+    std::vector<DocumentRecord> documents;
+    std::vector<uint32_t> doc_lengths;
+    std::vector<std::vector<search::DocID>> new_ids(parts.size());
+    for (size_t p = 0; p < parts.size(); ++p) {
+        const auto& segment = *parts[p].segment;
+        new_ids[p].assign(segment.DocCount(), search::kNoMoreDocs);
+        for (search::DocID doc_id = 0; doc_id < segment.DocCount(); ++doc_id) {
+            if (search::BitmapContains(parts[p].deleted.View(), doc_id)) {
+                continue;
+            }
+            new_ids[p][doc_id] = static_cast<search::DocID>(documents.size());
+            auto metadata = segment.Metadata(doc_id);
+            documents.push_back({std::string(metadata.id), std::string(metadata.title), std::string(metadata.url),
+                                 metadata.pageid, metadata.created_at});
+            doc_lengths.push_back(segment.DocLength(doc_id));
+        }
+    }
+
+    std::vector<std::pair<std::string, TermPostings>> merged;
+    std::vector<size_t> next_term(parts.size(), 0);
+    std::vector<std::string> current(parts.size());
+    for (size_t p = 0; p < parts.size(); ++p) {
+        if (parts[p].segment->TermCount() > 0) {
+            current[p] = parts[p].segment->Term(0);
+        }
+    }
+    while (true) {
+        const std::string* term = nullptr;
+        for (size_t p = 0; p < parts.size(); ++p) {
+            if (next_term[p] < parts[p].segment->TermCount() && (!term || current[p] < *term)) {
+                term = &current[p];
+            }
+        }
+        if (!term) {
+            break;
+        }
+        std::pair<std::string, TermPostings> entry{*term, {}};
+        for (size_t p = 0; p < parts.size(); ++p) {
+            const auto& segment = *parts[p].segment;
+            if (next_term[p] == segment.TermCount() || current[p] != entry.first) {
+                continue;
+            }
+            AppendLivePostings(segment, next_term[p], new_ids[p], entry.second);
+            if (++next_term[p] < segment.TermCount()) {
+                current[p] = segment.Term(next_term[p]);
+            }
+        }
+        if (!entry.second.docs.empty()) {
+            merged.push_back(std::move(entry));
+        }
+    }
+
+    // Recounted over the live documents. Their text is not kept, so the
+    // bytes and characters it had are unknown and left out.
+    IndexingStats stats = GetStats();
+    stats.docs_count = documents.size();
+    stats.total_bytes = 0;
+    stats.total_chars = 0;
+    stats.total_tokens = 0;
+    for (uint32_t length : doc_lengths) {
+        stats.total_tokens += length;
+    }
+    std::vector<size_t> freqs;
+    SortedPostings sorted_terms;
+    freqs.reserve(merged.size());
+    sorted_terms.reserve(merged.size());
+    for (const auto& [term, postings] : merged) {
+        freqs.push_back(Occurrences(postings));
+        sorted_terms.emplace_back(term, &postings);
+    }
+    stats.top_frequencies = TopFrequencies(std::move(freqs));
+    std::shared_ptr<const search::IndexSegment> segment = search::IndexSegment::FromBuffer(
+        SerializeSegment(sorted_terms, documents, doc_lengths, options_.stemmer, EncodeStats(stats)));
+    if (!incremental_options_.segment_path.empty()) {
+        try {
+            WriteSegmentFile(incremental_options_.segment_path, segment->Data(), segment->Size());
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: could not save merged segment: " << e.what() << std::endl;
+        }
+    }
+
+    segment_ = std::move(segment);
+    ResetDelta();
+    PublishSnapshot();
+    CatalogDocuments();
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.docs_count = stats.docs_count;
+    stats_.total_bytes = stats.total_bytes;
+    stats_.total_tokens = stats.total_tokens;
+    stats_.total_chars = stats.total_chars;
+    stats_.top_frequencies = stats.top_frequencies;
+    incremental_stats_.merges++;
+    incremental_stats_.delta_docs = 0;
+    incremental_stats_.last_merge_seconds = SecondsSince(start_time);
+}
+
+} // namespace indexing
@@ -0,0 +1,238 @@
+#include "indexing/segment_writer.hpp"
+#include "search/ranking.hpp"
+#include "text_processing/utf8_converter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t kSectionAlignment = 8;
+
+// A term found in at least one document in kBitmapDensity is stored as a
+// bitmap. From there a bit per docid is about as small as the varint gaps
+// and far cheaper to intersect.
+constexpr size_t kBitmapDensity = 16;
+
+// Term frequencies are stored in a byte; BM25 saturates long before that
+constexpr uint32_t kMaxStoredFreq = 255;
+
+// Rounds up, so a bound is never below a score the query side computes from
+// the same inputs, even after the sums are rounded in another order
+float ScoreBound(double score) {
+    return std::nextafter(static_cast<float>(score), std::numeric_limits<float>::infinity());
+}
+
+class SegmentBuffer {
+public:
+    SegmentBuffer() : bytes_(sizeof(search::SegmentHeader), 0) {}
+
+    search::SegmentSection Append(const void* data, size_t size) {
+        bytes_.resize((bytes_.size() + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment, 0);
+        search::SegmentSection section{bytes_.size(), size};
+        const char* begin = static_cast<const char*>(data);
+        bytes_.insert(bytes_.end(), begin, begin + size);
+        return section;
+    }
+
+    template <typename T>
+    search::SegmentSection Append(const std::vector<T>& items) {
+        return Append(items.data(), items.size() * sizeof(T));
+    }
+
+    std::vector<char> Finish(const search::SegmentHeader& header) {
+        std::memcpy(bytes_.data(), &header, sizeof(header));
+        return std::move(bytes_);
+    }
+
+private:
+    std::vector<char> bytes_;
+};
+
+} // anonymous namespace
+
+namespace indexing {
+
+std::vector<char> SerializeSegment(
+    const PostingsMap& postings,
+    const std::vector<DocumentRecord>& documents,
+    const std::vector<uint32_t>& doc_lengths,
+    text_processing::Stemmer stemmer,
+    const std::string& stats_blob
+) {
+    SortedPostings sorted_terms;
+    sorted_terms.reserve(postings.Size());
+    for (const auto& node : postings) {
+        sorted_terms.emplace_back(text_processing::WstringToUtf8(node.key), &node.value);
+    }
+    std::sort(sorted_terms.begin(), sorted_terms.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    return SerializeSegment(sorted_terms, documents, doc_lengths, stemmer, stats_blob);
+}
+
+std::vector<char> SerializeSegment(
+    const SortedPostings& sorted_terms,
+    const std::vector<DocumentRecord>& documents,
+    const std::vector<uint32_t>& doc_lengths,
+    text_processing::Stemmer stemmer,
+    const std::string& stats_blob
+) {
+    std::vector<std::string_view> term_strings;
+    term_strings.reserve(sorted_terms.size());
+    for (const auto& sorted : sorted_terms) {
+        term_strings.push_back(sorted.first);
+    }
+    auto dictionary = search::FrontCodeTerms(term_strings);
+
+    std::vector<search::SegmentTermEntry> terms;
+    std::vector<search::PostingBlockSkip> skips;
+    std::vector<uint8_t> data;
+    std::vector<uint64_t> bitmaps;
+    std::vector<uint32_t> bitmap_ranks;
+    std::vector<uint8_t> freqs;
+    std::vector<float> block_max_scores;
+    std::vector<uint8_t> positions;
+    std::vector<uint64_t> position_blocks;
+    std::vector<uint64_t> universe((documents.size() + 63) / 64, 0);
+    terms.reserve(sorted_terms.size());
+
+    uint64_t total_length = 0;
+    for (uint32_t length : doc_lengths) {
+        total_length += length;
+    }
+    double average_length = documents.empty() ? 0.0 : static_cast<double>(total_length) / documents.size();
+
+    for (const auto& [term, term_postings] : sorted_terms) {
+        const auto& list = term_postings->docs;
+        search::SegmentTermEntry entry{};
+        entry.doc_count = static_cast<uint32_t>(list.size());
+        entry.first_skip = skips.size();
+        entry.freq_offset = freqs.size();
+        entry.block_max_offset = block_max_scores.size();
+        entry.position_block_offset = position_blocks.size();
+
+        bool is_bitmap = list.size() * kBitmapDensity >= documents.size();
+        size_t block_count = 0;
+        if (is_bitmap) {
+            auto bitmap = search::ToBitmap(list);
+            auto ranks = search::BuildBitmapRanks(bitmap.View());
+            entry.container = search::PostingContainer::kBitmap;
+            entry.data_offset = bitmaps.size();
+            entry.data_size = bitmap.words.size();
+            entry.rank_offset = bitmap_ranks.size();
+            bitmaps.insert(bitmaps.end(), bitmap.words.begin(), bitmap.words.end());
+            bitmap_ranks.insert(bitmap_ranks.end(), ranks.begin(), ranks.end());
+            block_count = ranks.size();
+        } else {
+            search::CompressedPostingList compressed(list);
+            auto view = compressed.View();
+            entry.container = search::PostingContainer::kBlocks;
+            entry.block_count = view.block_count;
+            entry.data_offset = data.size();
+            entry.data_size = view.data_size;
+            skips.insert(skips.end(), view.skips, view.skips + view.block_count);
+            data.insert(data.end(), view.data, view.data + view.data_size);
+            block_count = view.block_count;
+        }
+
+        double idf = search::Bm25Idf(documents.size(), list.size());
+        std::vector<double> block_max(block_count, 0.0);
+        for (size_t i = 0; i < list.size(); ++i) {
+            search::DocID doc_id = list[i];
+            uint32_t freq = std::min(term_postings->freqs[i], kMaxStoredFreq);
+            freqs.push_back(static_cast<uint8_t>(freq));
+            universe[doc_id / 64] |= uint64_t{1} << (doc_id % 64);
+
+            double score = idf * search::Bm25TermWeight(freq, doc_lengths[doc_id], average_length);
+            size_t block = is_bitmap ? doc_id / search::kBitmapBlockDocs : i / search::kPostingBlockSize;
+            block_max[block] = std::max(block_max[block], score);
+        }
+        entry.max_score = 0;
+        for (double score : block_max) {
+            block_max_scores.push_back(ScoreBound(score));
+            entry.max_score = std::max(entry.max_score, block_max_scores.back());
+        }
+
+        if (!term_postings->positions.empty()) {
+            const uint32_t* posting_positions = term_postings->positions.data();
+            for (size_t i = 0; i < list.size(); ++i) {
+                if (i % search::kPostingBlockSize == 0) {
+                    position_blocks.push_back(positions.size());
+                }
+                search::AppendPositions(positions, posting_positions, term_postings->freqs[i]);
+                posting_positions += term_postings->freqs[i];
+            }
+        }
+        terms.push_back(entry);
+    }
+
+    std::vector<uint32_t> doc_string_offsets;
+    std::vector<char> doc_string_bytes;
+    std::vector<int32_t> doc_pageids;
+    std::vector<int32_t> doc_created_at;
+    doc_string_offsets.reserve(documents.size() * search::kDocStringFields + 1);
+    doc_pageids.reserve(documents.size());
+    doc_created_at.reserve(documents.size());
+    for (const auto& document : documents) {
+        for (const auto* field : {&document.id, &document.title, &document.url}) {
+            doc_string_offsets.push_back(static_cast<uint32_t>(doc_string_bytes.size()));
+            doc_string_bytes.insert(doc_string_bytes.end(), field->begin(), field->end());
+        }
+        doc_pageids.push_back(document.pageid);
+        doc_created_at.push_back(document.created_at);
+    }
+    doc_string_offsets.push_back(static_cast<uint32_t>(doc_string_bytes.size()));
+
+    search::SegmentHeader header{};
+    std::memcpy(header.magic, search::kSegmentMagic, sizeof(header.magic));
+    header.version = search::kSegmentVersion;
+    header.doc_count = static_cast<uint32_t>(documents.size());
+    header.term_count = terms.size();
+    header.total_length = total_length;
+    header.stemmer = static_cast<uint32_t>(stemmer);
+
+    SegmentBuffer buffer;
+    header.terms = buffer.Append(terms);
+    header.term_blocks = buffer.Append(dictionary.block_offsets);
+    header.term_bytes = buffer.Append(dictionary.bytes);
+    header.skips = buffer.Append(skips);
+    header.postings = buffer.Append(data);
+    header.bitmaps = buffer.Append(bitmaps);
+    header.bitmap_ranks = buffer.Append(bitmap_ranks);
+    header.freqs = buffer.Append(freqs);
+    header.block_max_scores = buffer.Append(block_max_scores);
+    header.positions = buffer.Append(positions);
+    header.position_blocks = buffer.Append(position_blocks);
+    header.doc_string_offsets = buffer.Append(doc_string_offsets);
+    header.doc_string_bytes = buffer.Append(doc_string_bytes);
+    header.doc_pageids = buffer.Append(doc_pageids);
+    header.doc_created_at = buffer.Append(doc_created_at);
+    header.universe = buffer.Append(universe);
+    header.doc_lengths = buffer.Append(doc_lengths);
+    header.stats = buffer.Append(stats_blob.data(), stats_blob.size());
+    return buffer.Finish(header);
+}
+
+void WriteSegmentFile(const std::string& path, const char* data, size_t size) {
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("cannot open " + tmp_path + " for writing");
+        }
+        out.write(data, static_cast<std::streamsize>(size));
+        if (!out) {
+            throw std::runtime_error("failed to write " + tmp_path);
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("cannot rename " + tmp_path + " to " + path);
+    }
+}
+
+} // namespace indexing
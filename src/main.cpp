@@ -7,6 +7,7 @@
 #include <thread>
 #include <chrono>
 #include <cstdlib>
+#include <algorithm>
 
 namespace {
 
@@ -21,6 +22,14 @@ constexpr const char* kDefaultMongoUri = "mongodb://localhost:27017";
 constexpr const char* kDefaultDbName = "wiki_corpus";
 constexpr const char* kDefaultCollectionName = "pages";
 constexpr int kDefaultServerPort = 8080;
+constexpr const char* kDefaultSegmentPath = "index.seg";
+constexpr int kDefaultIndexThreads = 0; // one per core
+constexpr int kDefaultIndexBatchSize = 500;
+constexpr int kDefaultIndexQueueDepth = 4;
+constexpr int kDefaultQueryCacheMb = 64;
+constexpr int kDefaultPollSeconds = 0; // incremental indexing off
+constexpr int kDefaultMergeDocs = 10000;
+constexpr const char* kDefaultStemmer = "light";
 
 std::string GetEnvOrDefault(const char* env_var, const char* default_value) {
     const char* value = std::getenv(env_var);
@@ -50,22 +59,55 @@ int main() {
         std::string db_name = GetEnvOrDefault("DB_NAME", kDefaultDbName);
         std::string collection_name = GetEnvOrDefault("COLLECTION_NAME", kDefaultCollectionName);
         int server_port = GetEnvIntOrDefault("SERVER_PORT", kDefaultServerPort);
+        std::string segment_path = GetEnvOrDefault("INDEX_SEGMENT_PATH", kDefaultSegmentPath);
+        indexing::IndexerOptions indexer_options;
+        indexer_options.num_threads = std::max(GetEnvIntOrDefault("INDEX_THREADS", kDefaultIndexThreads), 0);
+        indexer_options.batch_size = std::max(GetEnvIntOrDefault("INDEX_BATCH_SIZE", kDefaultIndexBatchSize), 1);
+        indexer_options.queue_depth = std::max(GetEnvIntOrDefault("INDEX_QUEUE_DEPTH", kDefaultIndexQueueDepth), 1);
+        indexer_options.positions = GetEnvIntOrDefault("INDEX_POSITIONS", 0) != 0;
+        std::string stemmer = GetEnvOrDefault("INDEX_STEMMER", kDefaultStemmer);
+        if (auto parsed = text_processing::ParseStemmer(stemmer)) {
+            indexer_options.stemmer = *parsed;
+        } else {
+            std::cerr << "Unknown INDEX_STEMMER " << stemmer << ", using " << kDefaultStemmer << std::endl;
+        }
+        size_t query_cache_bytes = static_cast<size_t>(std::max(GetEnvIntOrDefault("QUERY_CACHE_MB", kDefaultQueryCacheMb), 0)) << 20;
+        int poll_seconds = std::max(GetEnvIntOrDefault("INDEX_POLL_SECONDS", kDefaultPollSeconds), 0);
         
         std::cout << "Connecting to MongoDB at " << mongo_uri << "..." << std::endl;
         database::MongoDBClient db_client(mongo_uri, db_name, collection_name);
         
-        std::cout << "Building index..." << std::endl;
-        indexing::Indexer indexer(db_client);
-        indexer.BuildIndex();
+        indexing::Indexer indexer(db_client, indexer_options);
+        // New documents in the collection are picked up by polling anyway
+        if (indexer.LoadIndex(segment_path, poll_seconds > 0)) {
+            std::cout << "Loaded index segment " << segment_path << std::endl;
+        } else {
+            std::cout << "No usable index segment at " << segment_path << ", building index..." << std::endl;
+            indexer.BuildIndex();
+            try {
+                indexer.SaveIndex(segment_path);
+            } catch (const std::exception& e) {
+                std::cerr << "Warning: could not save index segment: " << e.what() << std::endl;
+            }
+        }
         
         auto stats = indexer.GetStats();
-        std::cout << "Indexing completed:" << std::endl;
+        std::cout << "Index ready:" << std::endl;
         std::cout << "  Documents: " << stats.docs_count << std::endl;
         std::cout << "  Total tokens: " << stats.total_tokens << std::endl;
         std::cout << "  Time: " << stats.elapsed_seconds << " seconds" << std::endl;
         
+        if (poll_seconds > 0) {
+            indexing::IncrementalOptions incremental_options;
+            incremental_options.poll_interval = std::chrono::seconds(poll_seconds);
+            incremental_options.merge_docs = static_cast<size_t>(std::max(GetEnvIntOrDefault("INDEX_MERGE_DOCS", kDefaultMergeDocs), 1));
+            incremental_options.segment_path = segment_path;
+            indexer.StartIncremental(incremental_options);
+            std::cout << "Polling for new documents every " << poll_seconds << " seconds" << std::endl;
+        }
+        
         std::cout << "Starting web server on port " << server_port << "..." << std::endl;
-        web::Server server(indexer, db_client, server_port);
+        web::Server server(indexer, server_port, query_cache_bytes);
         
         // Start server in a separate thread
         std::thread server_thread([&server]() {
@@ -81,6 +123,7 @@ int main() {
         std::cout << "\nShutting down..." << std::endl;
         server.Stop();
         server_thread.join();
+        indexer.StopIncremental();
         
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -1,21 +1,218 @@
 #include "search/boolean_search.hpp"
 #include "search/query_parser.hpp"
+#include "search/ranking.hpp"
 #include "text_processing/query_tokenizer.hpp"
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <utility>
 
 namespace search {
 
-containers::HashSet<DocID> BooleanSearchRu(const std::string& query, InvertedIndex& index) {
+namespace {
+
+// Leaves whose planner estimate is their exact number of matches
+bool HasExactEstimate(const PlanNode& plan) {
+    return plan.op == PlanOp::kEmpty || plan.op == PlanOp::kTerm || plan.op == PlanOp::kUniverse;
+}
+
+// One past the last match of the requested page
+size_t PageEnd(const SearchOptions& options) {
+    return options.max_docs > kAllDocs - options.offset ? kAllDocs : options.offset + options.max_docs;
+}
+
+void AppendPage(const std::vector<ScoredDoc>& hits, size_t offset, SearchResult& result) {
+    for (size_t i = offset; i < hits.size(); ++i) {
+        result.docs.push_back(hits[i].doc_id);
+        result.scores.push_back(hits[i].score);
+    }
+}
+
+void CollectTermNames(const PlanNode& plan, std::vector<const std::string*>& terms) {
+    if (plan.op == PlanOp::kTerm) {
+        terms.push_back(&plan.term);
+    }
+    for (const auto& child : plan.children) {
+        CollectTermNames(*child, terms);
+    }
+}
+
+// BM25 statistics with the live documents of every term of the plans,
+// summed over all the parts; doc_count and average_length are left to fill in
+Bm25Stats LiveDocFreqs(const std::vector<std::pair<const IndexSegment*, DocBitmapView>>& parts,
+                       const std::vector<const PlanNode*>& plans) {
+    std::vector<const std::string*> terms;
+    for (const PlanNode* plan : plans) {
+        CollectTermNames(*plan, terms);
+    }
+    Bm25Stats stats;
+    for (const std::string* term : terms) {
+        if (stats.doc_freqs.count(*term)) {
+            continue;
+        }
+        size_t doc_freq = 0;
+        for (const auto& [segment, deleted] : parts) {
+            if (auto postings = segment->Find(*term)) {
+                doc_freq += LiveDocFreq(*postings, deleted);
+            }
+        }
+        stats.doc_freqs.emplace(*term, doc_freq);
+    }
+    return stats;
+}
+
+SearchResult EvaluatePlan(PlanNodePtr plan, const IndexSegment& index, const SearchOptions& options,
+                          const DocBitmapView& deleted, const Bm25Stats* stats) {
+    SearchResult result;
+    size_t page_end = PageEnd(options);
+
+    if (options.ranked && page_end > 0 && IsTermDisjunction(*plan)) {
+        auto ranking = RankDisjunction(index, *plan, page_end, deleted, stats);
+        AppendPage(ranking.hits, options.offset, result);
+        result.count = ranking.scored;
+        result.count_exact = ranking.exact;
+    } else if (options.ranked) {
+        auto matches = BuildIterator(*plan, index);
+        Bm25Ranker ranker(index, *plan, page_end, stats);
+        for (DocID doc_id = matches->Doc(); doc_id != kNoMoreDocs; doc_id = matches->Next()) {
+            if (BitmapContains(deleted, doc_id)) {
+                continue;
+            }
+            ranker.Add(doc_id);
+            result.count++;
+        }
+        AppendPage(ranker.Finish(), options.offset, result);
+    } else {
+        auto matches = BuildIterator(*plan, index);
+        bool counted = HasExactEstimate(*plan) && deleted.count == 0;
+        for (DocID doc_id = matches->Doc(); doc_id != kNoMoreDocs; doc_id = matches->Next()) {
+            if (result.count >= page_end && counted) {
+                break;
+            }
+            if (BitmapContains(deleted, doc_id)) {
+                continue;
+            }
+            if (result.count >= options.offset && result.count < page_end) {
+                result.docs.push_back(doc_id);
+            }
+            result.count++;
+        }
+        if (counted) {
+            result.count = plan->estimate;
+        }
+    }
+
+    if (options.explain) {
+        CountPlanMatches(*plan, index);
+        result.plan = std::move(plan);
+    }
+    return result;
+}
+
+} // anonymous namespace
+
+QueryNodePtr ParseQueryRu(const std::string& query, text_processing::Stemmer stemmer,
+                          text_processing::SharedStemCache* stem_cache) {
     // Tokenize the query (handles operators &&, ||, ! and parentheses)
     auto tokens = text_processing::TokenizeQuery(query);
     
     if (tokens.empty()) {
-        return containers::HashSet<DocID>();
+        return std::make_unique<QueryNode>(QueryOp::kEmpty);
     }
     
     // Parse using recursive descent parser with proper operator precedence
-    QueryParser parser(tokens);
-    return parser.Parse(index);
+    QueryParser parser(tokens, stemmer, stem_cache);
+    return parser.Parse();
 }
 
-} // namespace search
+SearchResult EvaluateQuery(const QueryNode& query, const IndexSegment& index,
+                           const SearchOptions& options, const DocBitmapView& deleted) {
+    auto plan = PlanQuery(query, index);
+    if (!options.ranked || deleted.count == 0) {
+        return EvaluatePlan(std::move(plan), index, options, deleted, nullptr);
+    }
+    // The replaced documents must not count towards the statistics either
+    Bm25Stats stats = LiveDocFreqs({{&index, deleted}}, {plan.get()});
+    stats.doc_count = index.DocCount() - deleted.count;
+    if (stats.doc_count > 0) {
+        stats.average_length = static_cast<double>(index.TotalDocLength(deleted)) / stats.doc_count;
+    }
+    return EvaluatePlan(std::move(plan), index, options, deleted, &stats);
+}
+
+SearchResult EvaluateQuery(const QueryNode& query, const IndexSnapshot& snapshot,
+                           const SearchOptions& options) {
+    const auto& segments = snapshot.Segments();
+    if (segments.size() == 1) {
+        return EvaluateQuery(query, *segments[0].segment, options, segments[0].deleted.View());
+    }
+
+    // Each segment yields up to a whole page_end of matches and the page is
+    // cut from all of them: segments cover ascending docid ranges, so by
+    // docid their matches are already in order
+    size_t page_end = PageEnd(options);
+    SearchOptions segment_options = options;
+    segment_options.offset = 0;
+    segment_options.max_docs = page_end;
+
+    // Ranked, every segment scores with the statistics of the whole snapshot
+    std::vector<PlanNodePtr> plans;
+    std::optional<Bm25Stats> stats;
+    for (const auto& part : segments) {
+        plans.push_back(PlanQuery(query, *part.segment));
+    }
+    if (options.ranked) {
+        std::vector<std::pair<const IndexSegment*, DocBitmapView>> parts;
+        std::vector<const PlanNode*> part_plans;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            parts.emplace_back(segments[i].segment.get(), segments[i].deleted.View());
+            part_plans.push_back(plans[i].get());
+        }
+        stats = LiveDocFreqs(parts, part_plans);
+        stats->doc_count = snapshot.DocCount();
+        stats->average_length = snapshot.AverageDocLength();
+    }
 
+    SearchResult result;
+    std::vector<ScoredDoc> hits;
+    if (options.explain) {
+        result.plan = std::make_unique<PlanNode>();
+        result.plan->op = PlanOp::kOr;
+    }
+    for (size_t p = 0; p < segments.size(); ++p) {
+        const auto& part = segments[p];
+        auto partial = EvaluatePlan(std::move(plans[p]), *part.segment, segment_options, part.deleted.View(),
+                                    stats ? &*stats : nullptr);
+        result.count += partial.count;
+        result.count_exact = result.count_exact && partial.count_exact;
+        for (size_t i = 0; i < partial.docs.size(); ++i) {
+            hits.push_back({partial.docs[i] + part.first_doc, partial.scores.empty() ? 0.0 : partial.scores[i]});
+        }
+        if (partial.plan) {
+            result.plan->estimate += partial.plan->estimate;
+            result.plan->matches += partial.plan->matches;
+            result.plan->children.push_back(std::move(partial.plan));
+        }
+    }
+
+    if (options.ranked) {
+        std::stable_sort(hits.begin(), hits.end(), [](const ScoredDoc& a, const ScoredDoc& b) {
+            return a.score > b.score || (a.score == b.score && a.doc_id < b.doc_id);
+        });
+    }
+    hits.resize(std::min(hits.size(), page_end));
+    for (size_t i = options.offset; i < hits.size(); ++i) {
+        result.docs.push_back(hits[i].doc_id);
+        if (options.ranked) {
+            result.scores.push_back(hits[i].score);
+        }
+    }
+    return result;
+}
+
+SearchResult BooleanSearchRu(const std::string& query, const IndexSegment& index,
+                             const SearchOptions& options) {
+    return EvaluateQuery(*ParseQueryRu(query, index.Stemmer()), index, options);
+}
+
+} // namespace search
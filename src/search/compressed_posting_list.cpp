@@ -0,0 +1,184 @@
+#include "search/compressed_posting_list.hpp"
+#include "search/varint.hpp"
+#include <algorithm>
+
+namespace search {
+
+CompressedPostingList::CompressedPostingList(const PostingList& postings)
+    : doc_count_(static_cast<uint32_t>(postings.size())) {
+    skips_.reserve((postings.size() + kPostingBlockSize - 1) / kPostingBlockSize);
+
+    DocID prev = 0;
+    for (size_t i = 0; i < postings.size(); i += kPostingBlockSize) {
+        size_t end = std::min(i + kPostingBlockSize, postings.size());
+        skips_.push_back({postings[end - 1], static_cast<uint32_t>(data_.size())});
+        for (size_t j = i; j < end; ++j) {
+            AppendVarint(data_, postings[j] - prev);
+            prev = postings[j];
+        }
+    }
+    data_.shrink_to_fit();
+}
+
+size_t CompressedPostingList::MemoryUsage() const {
+    return sizeof(*this) + skips_.capacity() * sizeof(PostingBlockSkip) + data_.capacity();
+}
+
+PostingListView CompressedPostingList::View() const {
+    return {doc_count_, skips_.data(), static_cast<uint32_t>(skips_.size()),
+            data_.data(), static_cast<uint32_t>(data_.size()), {}};
+}
+
+PostingList CompressedPostingList::Decode() const {
+    return DecodePostings(View());
+}
+
+PostingListCursor::PostingListCursor(const PostingListView& view) : view_(view) {
+    if (view_.block_count > 0) {
+        DecodeBlock(0);
+        doc_ = buffer_[0];
+    }
+}
+
+void PostingListCursor::DecodeBlock(uint32_t block) {
+    block_ = block;
+    pos_ = 0;
+    block_len_ = block + 1 < view_.block_count
+        ? static_cast<uint32_t>(kPostingBlockSize)
+        : view_.doc_count - block * static_cast<uint32_t>(kPostingBlockSize);
+
+    const uint8_t* in = view_.data + view_.skips[block].byte_offset;
+    DocID prev = block > 0 ? view_.skips[block - 1].max_doc_id : 0;
+    for (uint32_t i = 0; i < block_len_; ++i) {
+        uint32_t gap;
+        in = ReadVarint(in, gap);
+        prev += gap;
+        buffer_[i] = prev;
+    }
+}
+
+DocID PostingListCursor::Next() {
+    if (AtEnd()) return doc_;
+
+    if (++pos_ < block_len_) {
+        doc_ = buffer_[pos_];
+    } else if (block_ + 1 < view_.block_count) {
+        DecodeBlock(block_ + 1);
+        doc_ = buffer_[0];
+    } else {
+        doc_ = kNoMoreDocs;
+    }
+    return doc_;
+}
+
+DocID PostingListCursor::Advance(DocID target) {
+    if (AtEnd() || doc_ >= target) return doc_;
+
+    if (view_.skips[block_].max_doc_id < target) {
+        // Binary search the skip table for the first block that can hold target
+        uint32_t lo = block_ + 1, hi = view_.block_count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (view_.skips[mid].max_doc_id < target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == view_.block_count) {
+            doc_ = kNoMoreDocs;
+            return doc_;
+        }
+        DecodeBlock(lo);
+    }
+
+    while (buffer_[pos_] < target) {
+        ++pos_;
+    }
+    doc_ = buffer_[pos_];
+    return doc_;
+}
+
+PostingList DecodePostings(const PostingListView& view) {
+    if (view.bitmap.words) {
+        return ToPostingList(view.bitmap);
+    }
+    PostingList result;
+    result.reserve(view.doc_count);
+    for (PostingListCursor cursor(view); !cursor.AtEnd(); cursor.Next()) {
+        result.push_back(cursor.Doc());
+    }
+    return result;
+}
+
+PostingList SetAnd(const PostingList& a, const PostingListView& b) {
+    if (b.bitmap.words) {
+        return SetAnd(a, b.bitmap);
+    }
+    PostingList result;
+    PostingListCursor cursor(b);
+    for (DocID doc_id : a) {
+        if (cursor.Advance(doc_id) == kNoMoreDocs) {
+            break;
+        }
+        if (cursor.Doc() == doc_id) {
+            result.push_back(doc_id);
+        }
+    }
+    return result;
+}
+
+void AppendPositions(std::vector<uint8_t>& out, const uint32_t* positions, uint32_t count) {
+    AppendVarint(out, count);
+    uint32_t prev = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        AppendVarint(out, positions[i] - prev);
+        prev = positions[i];
+    }
+}
+
+PositionCursor::PositionCursor(const PostingListView& view) : view_(view) {
+    if (!view_.bitmap.words) {
+        cursor_.emplace(view_);
+    }
+}
+
+const std::vector<uint32_t>& PositionCursor::Positions(DocID doc_id) {
+    uint32_t index;
+    if (cursor_) {
+        cursor_->Advance(doc_id);
+        index = cursor_->Index();
+    } else {
+        index = BitmapRank(view_.bitmap, view_.bitmap_ranks, doc_id);
+    }
+
+    // Postings before index in its block are skipped without decoding gaps
+    const uint8_t* in = next_;
+    uint32_t at = next_index_;
+    if (!in || index < at || index / kPostingBlockSize != at / kPostingBlockSize) {
+        at = index / kPostingBlockSize * kPostingBlockSize;
+        in = view_.positions + view_.position_blocks[index / kPostingBlockSize];
+    }
+    uint32_t count;
+    for (; at < index; ++at) {
+        in = ReadVarint(in, count);
+        for (uint32_t i = 0; i < count; ++i) {
+            while (*in++ & kVarintContinuation) {}
+        }
+    }
+
+    in = ReadVarint(in, count);
+    positions_.resize(count);
+    uint32_t position = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t gap;
+        in = ReadVarint(in, gap);
+        position += gap;
+        positions_[i] = position;
+    }
+    next_index_ = index + 1;
+    next_ = in;
+    return positions_;
+}
+
+} // namespace search
@@ -0,0 +1,188 @@
+#include "search/index_segment.hpp"
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<uint64_t> g_next_generation{1};
+
+bool SectionFits(const search::SegmentSection& section, size_t file_size) {
+    return section.offset <= file_size && section.size <= file_size - section.offset;
+}
+
+} // anonymous namespace
+
+namespace search {
+
+uint64_t NextGeneration() {
+    return g_next_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+IndexSegment::~IndexSegment() {
+    if (mapping_) {
+        munmap(mapping_, size_);
+    }
+}
+
+std::unique_ptr<IndexSegment> IndexSegment::Open(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SegmentHeader)) {
+        close(fd);
+        return nullptr;
+    }
+
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::unique_ptr<IndexSegment> segment(new IndexSegment());
+    segment->mapping_ = mapping;
+    segment->data_ = static_cast<const char*>(mapping);
+    segment->size_ = st.st_size;
+    if (!segment->Init()) {
+        return nullptr;
+    }
+    return segment;
+}
+
+std::unique_ptr<IndexSegment> IndexSegment::FromBuffer(std::vector<char> buffer) {
+    std::unique_ptr<IndexSegment> segment(new IndexSegment());
+    segment->buffer_ = std::move(buffer);
+    segment->data_ = segment->buffer_.data();
+    segment->size_ = segment->buffer_.size();
+    if (segment->size_ < sizeof(SegmentHeader) || !segment->Init()) {
+        return nullptr;
+    }
+    return segment;
+}
+
+bool IndexSegment::Init() {
+    header_ = reinterpret_cast<const SegmentHeader*>(data_);
+    if (std::memcmp(header_->magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0 ||
+        header_->version != kSegmentVersion ||
+        header_->stemmer > static_cast<uint32_t>(text_processing::Stemmer::kSnowball)) {
+        return false;
+    }
+
+    for (const auto* section : {&header_->terms, &header_->term_blocks, &header_->term_bytes,
+                                &header_->skips, &header_->postings, &header_->bitmaps, &header_->bitmap_ranks,
+                                &header_->freqs, &header_->block_max_scores,
+                                &header_->positions, &header_->position_blocks,
+                                &header_->doc_string_offsets, &header_->doc_string_bytes,
+                                &header_->doc_pageids, &header_->doc_created_at,
+                                &header_->universe, &header_->doc_lengths, &header_->stats}) {
+        if (!SectionFits(*section, size_)) {
+            return false;
+        }
+    }
+    if (header_->terms.size != header_->term_count * sizeof(SegmentTermEntry) ||
+        header_->term_blocks.size != (header_->term_count + kTermBlockSize - 1) / kTermBlockSize * sizeof(uint32_t) ||
+        header_->doc_string_offsets.size != (header_->doc_count * kDocStringFields + 1) * sizeof(uint32_t) ||
+        header_->doc_pageids.size != header_->doc_count * sizeof(int32_t) ||
+        header_->doc_created_at.size != header_->doc_count * sizeof(int32_t) ||
+        header_->universe.size != (header_->doc_count + 63) / 64 * sizeof(uint64_t) ||
+        header_->doc_lengths.size != header_->doc_count * sizeof(uint32_t)) {
+        return false;
+    }
+
+    terms_ = reinterpret_cast<const SegmentTermEntry*>(data_ + header_->terms.offset);
+    dictionary_ = TermDictionary(reinterpret_cast<const uint32_t*>(data_ + header_->term_blocks.offset),
+                                 reinterpret_cast<const uint8_t*>(data_ + header_->term_bytes.offset),
+                                 header_->term_count);
+    skips_ = reinterpret_cast<const PostingBlockSkip*>(data_ + header_->skips.offset);
+    postings_ = reinterpret_cast<const uint8_t*>(data_ + header_->postings.offset);
+    bitmaps_ = reinterpret_cast<const uint64_t*>(data_ + header_->bitmaps.offset);
+    bitmap_ranks_ = reinterpret_cast<const uint32_t*>(data_ + header_->bitmap_ranks.offset);
+    freqs_ = reinterpret_cast<const uint8_t*>(data_ + header_->freqs.offset);
+    block_max_scores_ = reinterpret_cast<const float*>(data_ + header_->block_max_scores.offset);
+    positions_ = reinterpret_cast<const uint8_t*>(data_ + header_->positions.offset);
+    position_blocks_ = reinterpret_cast<const uint64_t*>(data_ + header_->position_blocks.offset);
+    doc_lengths_ = reinterpret_cast<const uint32_t*>(data_ + header_->doc_lengths.offset);
+    doc_string_offsets_ = reinterpret_cast<const uint32_t*>(data_ + header_->doc_string_offsets.offset);
+    doc_string_bytes_ = data_ + header_->doc_string_bytes.offset;
+    doc_pageids_ = reinterpret_cast<const int32_t*>(data_ + header_->doc_pageids.offset);
+    doc_created_at_ = reinterpret_cast<const int32_t*>(data_ + header_->doc_created_at.offset);
+
+    generation_ = NextGeneration();
+    universe_.words = reinterpret_cast<const uint64_t*>(data_ + header_->universe.offset);
+    universe_.word_count = static_cast<uint32_t>(header_->universe.size / sizeof(uint64_t));
+    universe_.count = 0;
+    for (uint32_t i = 0; i < universe_.word_count; ++i) {
+        universe_.count += std::popcount(universe_.words[i]);
+    }
+    return true;
+}
+
+PostingListView IndexSegment::Postings(size_t term_idx) const {
+    const auto& entry = terms_[term_idx];
+    PostingListView view;
+    view.doc_count = entry.doc_count;
+    view.freqs = freqs_ + entry.freq_offset;
+    view.block_max_scores = block_max_scores_ + entry.block_max_offset;
+    view.max_score = entry.max_score;
+    if (HasPositions()) {
+        view.position_blocks = position_blocks_ + entry.position_block_offset;
+        view.positions = positions_;
+    }
+    if (entry.container == PostingContainer::kBitmap) {
+        view.bitmap = {bitmaps_ + entry.data_offset, static_cast<uint32_t>(entry.data_size), entry.doc_count};
+        view.bitmap_ranks = bitmap_ranks_ + entry.rank_offset;
+    } else {
+        view.skips = skips_ + entry.first_skip;
+        view.block_count = entry.block_count;
+        view.data = postings_ + entry.data_offset;
+        view.data_size = static_cast<uint32_t>(entry.data_size);
+    }
+    return view;
+}
+
+std::optional<PostingListView> IndexSegment::Find(std::string_view term) const {
+    auto term_idx = dictionary_.Find(term);
+    if (!term_idx) {
+        return std::nullopt;
+    }
+    return Postings(*term_idx);
+}
+
+std::string_view IndexSegment::DocString(DocID doc_id, DocStringField field) const {
+    size_t slot = static_cast<size_t>(doc_id) * kDocStringFields + field;
+    uint32_t begin = doc_string_offsets_[slot];
+    return {doc_string_bytes_ + begin, doc_string_offsets_[slot + 1] - begin};
+}
+
+DocumentMetadata IndexSegment::Metadata(DocID doc_id) const {
+    return {DocString(doc_id, kDocIdField), DocString(doc_id, kDocTitleField), DocString(doc_id, kDocUrlField),
+            doc_pageids_[doc_id], doc_created_at_[doc_id]};
+}
+
+double IndexSegment::AverageDocLength() const {
+    return DocCount() > 0 ? static_cast<double>(header_->total_length) / DocCount() : 0.0;
+}
+
+uint64_t IndexSegment::TotalDocLength(const DocBitmapView& deleted) const {
+    uint64_t total = header_->total_length;
+    for (size_t word = 0; word < deleted.word_count; ++word) {
+        for (uint64_t bits = deleted.words[word]; bits != 0; bits &= bits - 1) {
+            total -= DocLength(static_cast<DocID>(word * 64 + std::countr_zero(bits)));
+        }
+    }
+    return total;
+}
+
+std::string_view IndexSegment::StatsBlob() const {
+    return {data_ + header_->stats.offset, header_->stats.size};
+}
+
+} // namespace search
@@ -0,0 +1,21 @@
+#include "search/index_snapshot.hpp"
+#include <algorithm>
+
+namespace search {
+
+IndexSnapshot::IndexSnapshot(std::vector<SnapshotSegment> segments)
+    : segments_(std::move(segments)), generation_(NextGeneration()) {
+    for (const auto& part : segments_) {
+        doc_count_ += part.segment->DocCount() - part.deleted.count;
+        total_length_ += part.segment->TotalDocLength(part.deleted.View());
+    }
+}
+
+DocumentMetadata IndexSnapshot::Metadata(DocID doc_id) const {
+    auto part = std::upper_bound(segments_.begin(), segments_.end(), doc_id,
+                                 [](DocID doc, const SnapshotSegment& segment) { return doc < segment.first_doc; });
+    --part;
+    return part->segment->Metadata(doc_id - part->first_doc);
+}
+
+} // namespace search
@@ -0,0 +1,249 @@
+#include "search/posting_iterator.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace search {
+
+namespace {
+
+bool SameTerm(const PostingListView& a, const PostingListView& b) {
+    return a.data == b.data && a.bitmap.words == b.bitmap.words && a.positions == b.positions;
+}
+
+} // anonymous namespace
+
+ListIterator::ListIterator(PostingList docs) : docs_(std::move(docs)) {}
+
+DocID ListIterator::Doc() const {
+    return pos_ < docs_.size() ? docs_[pos_] : kNoMoreDocs;
+}
+
+DocID ListIterator::Next() {
+    if (pos_ < docs_.size()) {
+        ++pos_;
+    }
+    return Doc();
+}
+
+DocID ListIterator::Advance(DocID target) {
+    if (Doc() >= target) return Doc();
+    pos_ = std::lower_bound(docs_.begin() + pos_, docs_.end(), target) - docs_.begin();
+    return Doc();
+}
+
+BitmapIterator::BitmapIterator(const DocBitmapView& bitmap) : bitmap_(bitmap) {
+    Seek(0);
+}
+
+BitmapIterator::BitmapIterator(DocBitmap bitmap) : owned_(std::move(bitmap)), bitmap_(owned_.View()) {
+    Seek(0);
+}
+
+DocID BitmapIterator::Seek(DocID target) {
+    size_t word = target / 64;
+    if (word >= bitmap_.word_count) return doc_ = kNoMoreDocs;
+    uint64_t bits = bitmap_.words[word] & (~uint64_t{0} << (target % 64));
+    while (bits == 0) {
+        if (++word == bitmap_.word_count) return doc_ = kNoMoreDocs;
+        bits = bitmap_.words[word];
+    }
+    return doc_ = static_cast<DocID>(word * 64 + std::countr_zero(bits));
+}
+
+DocID BitmapIterator::Next() {
+    if (doc_ == kNoMoreDocs) return doc_;
+    return Seek(doc_ + 1);
+}
+
+DocID BitmapIterator::Advance(DocID target) {
+    if (doc_ >= target) return doc_;
+    return Seek(target);
+}
+
+AndIterator::AndIterator(std::vector<PostingIteratorPtr> children) : children_(std::move(children)) {
+    doc_ = Align(children_.front()->Doc());
+}
+
+DocID AndIterator::Align(DocID target) {
+    while (target != kNoMoreDocs) {
+        target = children_.front()->Advance(target);
+        bool matched = true;
+        for (size_t i = 1; i < children_.size() && target != kNoMoreDocs; ++i) {
+            DocID doc_id = children_[i]->Advance(target);
+            if (doc_id != target) {
+                target = doc_id;
+                matched = false;
+                break;
+            }
+        }
+        if (matched) break;
+    }
+    return doc_ = target;
+}
+
+DocID AndIterator::Next() {
+    if (doc_ == kNoMoreDocs) return doc_;
+    return Align(children_.front()->Next());
+}
+
+DocID AndIterator::Advance(DocID target) {
+    if (doc_ >= target) return doc_;
+    return Align(children_.front()->Advance(target));
+}
+
+OrIterator::OrIterator(std::vector<PostingIteratorPtr> children) : children_(std::move(children)) {
+    for (const auto& child : children_) {
+        cost_ += child->Cost();
+    }
+    UpdateDoc();
+}
+
+DocID OrIterator::UpdateDoc() {
+    doc_ = kNoMoreDocs;
+    for (const auto& child : children_) {
+        doc_ = std::min(doc_, child->Doc());
+    }
+    return doc_;
+}
+
+DocID OrIterator::Next() {
+    if (doc_ == kNoMoreDocs) return doc_;
+    for (auto& child : children_) {
+        if (child->Doc() == doc_) {
+            child->Next();
+        }
+    }
+    return UpdateDoc();
+}
+
+DocID OrIterator::Advance(DocID target) {
+    if (doc_ >= target) return doc_;
+    for (auto& child : children_) {
+        child->Advance(target);
+    }
+    return UpdateDoc();
+}
+
+AndNotIterator::AndNotIterator(PostingIteratorPtr include, PostingIteratorPtr exclude)
+    : include_(std::move(include)), exclude_(std::move(exclude)) {
+    SkipExcluded();
+}
+
+DocID AndNotIterator::SkipExcluded() {
+    DocID doc_id = include_->Doc();
+    while (doc_id != kNoMoreDocs && exclude_->Advance(doc_id) == doc_id) {
+        doc_id = include_->Next();
+    }
+    return doc_id;
+}
+
+DocID AndNotIterator::Next() {
+    if (include_->Doc() == kNoMoreDocs) return kNoMoreDocs;
+    include_->Next();
+    return SkipExcluded();
+}
+
+DocID AndNotIterator::Advance(DocID target) {
+    if (include_->Doc() >= target) return include_->Doc();
+    include_->Advance(target);
+    return SkipExcluded();
+}
+
+PositionalIterator::PositionalIterator(PostingIteratorPtr candidates, std::vector<PostingListView> terms,
+                                       PositionalMatch match, uint32_t distance)
+    : candidates_(std::move(candidates)), term_count_(terms.size()), match_(match), distance_(distance) {
+    std::vector<PostingListView> distinct;
+    for (const auto& term : terms) {
+        auto it = std::find_if(distinct.begin(), distinct.end(),
+                               [&](const PostingListView& other) { return SameTerm(term, other); });
+        if (match_ == PositionalMatch::kNear && it != distinct.end()) {
+            copies_[it - distinct.begin()]++;
+            continue;
+        }
+        distinct.push_back(term);
+        copies_.push_back(1);
+        cursors_.emplace_back(term);
+    }
+    positions_.resize(cursors_.size());
+    heads_.resize(cursors_.size());
+    doc_ = SkipMismatches(candidates_->Doc());
+}
+
+DocID PositionalIterator::Next() {
+    if (doc_ == kNoMoreDocs) return kNoMoreDocs;
+    doc_ = SkipMismatches(candidates_->Next());
+    return doc_;
+}
+
+DocID PositionalIterator::Advance(DocID target) {
+    if (doc_ >= target) return doc_;
+    doc_ = SkipMismatches(candidates_->Advance(target));
+    return doc_;
+}
+
+DocID PositionalIterator::SkipMismatches(DocID doc_id) {
+    for (; doc_id != kNoMoreDocs; doc_id = candidates_->Next()) {
+        for (size_t i = 0; i < cursors_.size(); ++i) {
+            positions_[i] = &cursors_[i].Positions(doc_id);
+            heads_[i] = 0;
+        }
+        if (match_ == PositionalMatch::kPhrase ? MatchesPhrase() : MatchesNear()) {
+            return doc_id;
+        }
+    }
+    return kNoMoreDocs;
+}
+
+// Some p where term i occurs at p + i for every i
+bool PositionalIterator::MatchesPhrase() {
+    for (uint32_t start : *positions_[0]) {
+        bool matched = true;
+        for (size_t i = 1; i < positions_.size() && matched; ++i) {
+            const auto& positions = *positions_[i];
+            size_t& head = heads_[i];
+            while (head < positions.size() && positions[head] < start + i) {
+                ++head;
+            }
+            if (head == positions.size()) {
+                return false;
+            }
+            matched = positions[head] == start + i;
+        }
+        if (matched) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Slides a window holding the current occurrences of every term, moving the
+// earliest one forward, until at most distance other words are left inside
+// it or a term runs out. A term given n times holds n consecutive
+// occurrences, so that "a NEAR a" needs two of them.
+bool PositionalIterator::MatchesNear() {
+    for (size_t i = 0; i < positions_.size(); ++i) {
+        if (positions_[i]->size() < copies_[i]) {
+            return false;
+        }
+    }
+    while (true) {
+        size_t earliest = 0;
+        uint32_t first = UINT32_MAX, last = 0;
+        for (size_t i = 0; i < positions_.size(); ++i) {
+            const auto& positions = *positions_[i];
+            if (positions[heads_[i]] < first) {
+                first = positions[heads_[i]];
+                earliest = i;
+            }
+            last = std::max(last, positions[heads_[i] + copies_[i] - 1]);
+        }
+        if (last - first < distance_ + term_count_) {
+            return true;
+        }
+        if (++heads_[earliest] + copies_[earliest] > positions_[earliest]->size()) {
+            return false;
+        }
+    }
+}
+
+} // namespace search
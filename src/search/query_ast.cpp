@@ -0,0 +1,76 @@
+#include "search/query_ast.hpp"
+#include <algorithm>
+
+namespace search {
+
+namespace {
+
+void CollectOperands(const QueryNode& node, QueryOp op, std::vector<std::string>& operands) {
+    for (const auto& child : node.children) {
+        if (child->op == op) {
+            CollectOperands(*child, op, operands);
+        } else {
+            operands.push_back(CanonicalQuery(*child));
+        }
+    }
+}
+
+} // anonymous namespace
+
+std::string CanonicalQuery(const QueryNode& query) {
+    switch (query.op) {
+        case QueryOp::kTerm:
+            return query.term;
+        case QueryOp::kPrefix:
+            return query.term + "*";
+        case QueryOp::kPhrase: {
+            std::string canonical = "\"";
+            for (size_t i = 0; i < query.children.size(); ++i) {
+                canonical += i > 0 ? " " : "";
+                canonical += query.children[i]->term;
+            }
+            return canonical + "\"";
+        }
+        case QueryOp::kNear: {
+            std::vector<std::string> operands;
+            for (const auto& child : query.children) {
+                operands.push_back(child->term);
+            }
+            std::sort(operands.begin(), operands.end());
+            std::string canonical = "NEAR/" + std::to_string(query.distance) + "(";
+            for (size_t i = 0; i < operands.size(); ++i) {
+                canonical += i > 0 ? "," : "";
+                canonical += operands[i];
+            }
+            return canonical + ")";
+        }
+        case QueryOp::kNot: {
+            const auto& operand = *query.children.front();
+            if (operand.op == QueryOp::kNot) {
+                return CanonicalQuery(*operand.children.front());
+            }
+            return "!" + CanonicalQuery(operand);
+        }
+        case QueryOp::kAnd:
+        case QueryOp::kOr: {
+            std::vector<std::string> operands;
+            CollectOperands(query, query.op, operands);
+            std::sort(operands.begin(), operands.end());
+            operands.erase(std::unique(operands.begin(), operands.end()), operands.end());
+            if (operands.size() == 1) {
+                return operands.front();
+            }
+            std::string canonical = query.op == QueryOp::kAnd ? "&(" : "|(";
+            for (size_t i = 0; i < operands.size(); ++i) {
+                canonical += i > 0 ? "," : "";
+                canonical += operands[i];
+            }
+            return canonical + ")";
+        }
+        case QueryOp::kEmpty:
+            break;
+    }
+    return "()";
+}
+
+} // namespace search
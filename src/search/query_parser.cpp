@@ -1,6 +1,8 @@
 #include "search/query_parser.hpp"
 #include "text_processing/stemmer.hpp"
-#include "search/set_operations.hpp"
+#include "text_processing/utf8_converter.hpp"
+#include <algorithm>
+#include <string_view>
 
 namespace {
 
@@ -9,6 +11,17 @@ constexpr const wchar_t* kOpOr = L"||";
 constexpr const wchar_t* kOpNot = L"!";
 constexpr const wchar_t* kLeftParen = L"(";
 constexpr const wchar_t* kRightParen = L")";
+constexpr wchar_t kPrefixWildcard = L'*';
+constexpr const wchar_t* kQuote = L"\"";
+constexpr std::wstring_view kNearPrefix = L"NEAR/";
+
+search::QueryNodePtr MakeTerm(const std::wstring& word, text_processing::Stemmer stemmer,
+                              text_processing::SharedStemCache* stem_cache) {
+    size_t stem_length = stem_cache ? stem_cache->StemLength(word, stemmer)
+                                    : text_processing::StemLengthRu(word, stemmer);
+    auto stem = word.substr(0, stem_length);
+    return std::make_unique<search::QueryNode>(search::QueryOp::kTerm, text_processing::WstringToUtf8(stem));
+}
 
 bool IsOperator(const std::wstring& token) {
     return token == kOpAnd || token == kOpOr || token == kOpNot;
@@ -25,8 +38,9 @@ search::TokenType GetOperatorType(const std::wstring& token) {
 
 namespace search {
 
-QueryParser::QueryParser(const std::vector<std::wstring>& tokens)
-    : current_pos_(0) {
+QueryParser::QueryParser(const std::vector<std::wstring>& tokens, text_processing::Stemmer stemmer,
+                         text_processing::SharedStemCache* stem_cache)
+    : current_pos_(0), stemmer_(stemmer), stem_cache_(stem_cache) {
     Tokenize(tokens);
 }
 
@@ -44,6 +58,12 @@ void QueryParser::Tokenize(const std::vector<std::wstring>& input_tokens) {
             tokens_.emplace_back(TokenType::kLeftParen);
         } else if (token == kRightParen) {
             tokens_.emplace_back(TokenType::kRightParen);
+        } else if (token == kQuote) {
+            tokens_.emplace_back(TokenType::kQuote);
+        } else if (token.starts_with(kNearPrefix)) {
+            tokens_.emplace_back(TokenType::kNear, token.substr(kNearPrefix.size()));
+        } else if (token.size() > 1 && token.back() == kPrefixWildcard) {
+            tokens_.emplace_back(TokenType::kPrefix, token.substr(0, token.size() - 1));
         } else if (!token.empty()) {
             tokens_.emplace_back(TokenType::kTerm, token);
         }
@@ -52,86 +72,134 @@ void QueryParser::Tokenize(const std::vector<std::wstring>& input_tokens) {
     tokens_.emplace_back(TokenType::kEnd);
 }
 
-containers::HashSet<DocID> QueryParser::Parse(InvertedIndex& index) {
+QueryNodePtr QueryParser::Parse() {
     current_pos_ = 0;
-    auto result = ParseOrExpression(index);
+    auto result = ParseOrExpression();
     
     if (CurrentToken().type != TokenType::kEnd) {
         // Unexpected token, return empty result
-        return containers::HashSet<DocID>();
+        return std::make_unique<QueryNode>(QueryOp::kEmpty);
     }
     
     return result;
 }
 
-containers::HashSet<DocID> QueryParser::ParseOrExpression(InvertedIndex& index) {
-    auto result = ParseAndExpression(index);
-    
+QueryNodePtr QueryParser::ParseOrExpression() {
+    auto left = ParseAndExpression();
+    if (CurrentToken().type != TokenType::kOperatorOr) {
+        return left;
+    }
+
+    auto node = std::make_unique<QueryNode>(QueryOp::kOr);
+    node->children.push_back(std::move(left));
     while (Match(TokenType::kOperatorOr)) {
-        auto right = ParseAndExpression(index);
-        result = SetOr(result, right);
+        node->children.push_back(ParseAndExpression());
     }
-    
-    return result;
+    return node;
 }
 
-containers::HashSet<DocID> QueryParser::ParseAndExpression(InvertedIndex& index) {
-    auto result = ParseNotExpression(index);
-    
+QueryNodePtr QueryParser::ParseAndExpression() {
+    auto left = ParseNotExpression();
+    if (CurrentToken().type != TokenType::kOperatorAnd) {
+        return left;
+    }
+
+    auto node = std::make_unique<QueryNode>(QueryOp::kAnd);
+    node->children.push_back(std::move(left));
     while (Match(TokenType::kOperatorAnd)) {
-        auto right = ParseNotExpression(index);
-        result = SetAnd(result, right);
+        node->children.push_back(ParseNotExpression());
     }
-    
-    return result;
+    return node;
 }
 
-containers::HashSet<DocID> QueryParser::ParseNotExpression(InvertedIndex& index) {
+QueryNodePtr QueryParser::ParseNotExpression() {
     if (Match(TokenType::kOperatorNot)) {
-        auto result = ParseNotExpression(index);
-        containers::HashSet<DocID> all_docs;
-        for (const auto& node : index) {
-            for (const auto& doc_id : node.value) {
-                all_docs.Insert(doc_id);
-            }
-        }
-
-        for (const auto& doc_id : result) {
-            all_docs.Erase(doc_id);
-        }
-        
-        return all_docs;
+        auto node = std::make_unique<QueryNode>(QueryOp::kNot);
+        node->children.push_back(ParseNotExpression());
+        return node;
     }
     
-    return ParseTerm(index);
+    return ParseTerm();
 }
 
-containers::HashSet<DocID> QueryParser::ParseTerm(InvertedIndex& index) {
+QueryNodePtr QueryParser::ParseTerm() {
     if (Match(TokenType::kLeftParen)) {
-        auto result = ParseOrExpression(index);
+        auto result = ParseOrExpression();
         if (!Match(TokenType::kRightParen)) {
             // Mismatched parentheses
-            return containers::HashSet<DocID>();
+            return std::make_unique<QueryNode>(QueryOp::kEmpty);
         }
         return result;
     }
     
+    if (Match(TokenType::kQuote)) {
+        return ParsePhrase();
+    }
+
     if (CurrentToken().type == TokenType::kTerm) {
-        auto token = CurrentToken();
+        auto term = MakeTerm(CurrentToken().value, stemmer_, stem_cache_);
         Advance();
-        
-        auto stem = text_processing::StemRu(token.value);
-        // Use operator[] which creates empty set if not found
-        return index[stem];
+        if (CurrentToken().type == TokenType::kNear) {
+            return ParseNear(std::move(term));
+        }
+        return term;
+    }
+
+    if (CurrentToken().type == TokenType::kPrefix) {
+        // Matched against the stems as typed; stemming could strip letters
+        // the prefix was meant to keep
+        auto prefix = text_processing::WstringToUtf8(CurrentToken().value);
+        Advance();
+        return std::make_unique<QueryNode>(QueryOp::kPrefix, std::move(prefix));
     }
     
     // Unexpected token
-    return containers::HashSet<DocID>();
+    return std::make_unique<QueryNode>(QueryOp::kEmpty);
+}
+
+// The words up to the closing quote; one word is just a term
+QueryNodePtr QueryParser::ParsePhrase() {
+    auto phrase = std::make_unique<QueryNode>(QueryOp::kPhrase);
+    while (CurrentToken().type == TokenType::kTerm) {
+        phrase->children.push_back(MakeTerm(CurrentToken().value, stemmer_, stem_cache_));
+        Advance();
+    }
+    if (!Match(TokenType::kQuote) || phrase->children.empty()) {
+        return std::make_unique<QueryNode>(QueryOp::kEmpty);
+    }
+    if (phrase->children.size() == 1) {
+        return std::move(phrase->children.front());
+    }
+    return phrase;
+}
+
+// term NEAR/k term [NEAR/k term ...]: all the terms inside one window of the
+// largest k given
+QueryNodePtr QueryParser::ParseNear(QueryNodePtr first) {
+    auto near = std::make_unique<QueryNode>(QueryOp::kNear);
+    near->children.push_back(std::move(first));
+    while (CurrentToken().type == TokenType::kNear) {
+        uint32_t distance = 0;
+        try {
+            distance = static_cast<uint32_t>(std::min<unsigned long>(std::stoul(CurrentToken().value), UINT32_MAX));
+        } catch (...) {
+            return std::make_unique<QueryNode>(QueryOp::kEmpty);
+        }
+        near->distance = std::max(near->distance, distance);
+        Advance();
+        if (CurrentToken().type != TokenType::kTerm) {
+            return std::make_unique<QueryNode>(QueryOp::kEmpty);
+        }
+        near->children.push_back(MakeTerm(CurrentToken().value, stemmer_, stem_cache_));
+        Advance();
+    }
+    return near;
 }
 
-Token QueryParser::CurrentToken() const {
+const Token& QueryParser::CurrentToken() const {
+    // tokens_ always ends with kEnd
     if (current_pos_ >= tokens_.size()) {
-        return Token(TokenType::kEnd);
+        return tokens_.back();
     }
     return tokens_[current_pos_];
 }
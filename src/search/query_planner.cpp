@@ -0,0 +1,393 @@
+#include "search/query_planner.hpp"
+#include <algorithm>
+#include <bit>
+#include <optional>
+#include <utility>
+
+namespace {
+
+using search::PlanNode;
+using search::PlanNodePtr;
+using search::PlanOp;
+using search::QueryNode;
+using search::QueryOp;
+
+// Unions of at least this many leaves, such as expanded prefixes, are
+// collected into a single bitmap
+constexpr size_t kWideUnionLeaves = 16;
+
+PlanNodePtr MakeNode(PlanOp op, size_t estimate) {
+    auto node = std::make_unique<PlanNode>();
+    node->op = op;
+    node->estimate = estimate;
+    return node;
+}
+
+// A union can match no more documents than the segment holds
+size_t UnionEstimate(const std::vector<PlanNodePtr>& children, size_t universe) {
+    size_t estimate = 0;
+    for (const auto& child : children) {
+        estimate += child->estimate;
+    }
+    return std::min(estimate, universe);
+}
+
+PlanNodePtr MakeUnion(std::vector<PlanNodePtr> children, size_t universe) {
+    if (children.empty()) {
+        return MakeNode(PlanOp::kEmpty, 0);
+    }
+    if (children.size() == 1) {
+        return std::move(children.front());
+    }
+    auto node = MakeNode(PlanOp::kOr, UnionEstimate(children, universe));
+    node->children = std::move(children);
+    return node;
+}
+
+// Appends a union's operands in place of the union itself
+void AppendFlattened(PlanNodePtr plan, PlanOp op, std::vector<PlanNodePtr>& operands) {
+    if (plan->op == op) {
+        for (auto& child : plan->children) {
+            operands.push_back(std::move(child));
+        }
+    } else {
+        operands.push_back(std::move(plan));
+    }
+}
+
+// Splits a conjunction into its operands and their polarity, looking through
+// nested ANDs and double negations.
+void CollectConjuncts(const QueryNode& node, bool negated,
+                      std::vector<std::pair<const QueryNode*, bool>>& operands) {
+    if (node.op == QueryOp::kNot) {
+        CollectConjuncts(*node.children.front(), !negated, operands);
+    } else if (node.op == QueryOp::kAnd && !negated) {
+        for (const auto& child : node.children) {
+            CollectConjuncts(*child, false, operands);
+        }
+    } else {
+        operands.emplace_back(&node, negated);
+    }
+}
+
+PlanNodePtr Plan(const QueryNode& node, const search::IndexSegment& index);
+
+PlanNodePtr PlanConjunction(const QueryNode& node, const search::IndexSegment& index) {
+    std::vector<std::pair<const QueryNode*, bool>> operands;
+    CollectConjuncts(node, false, operands);
+
+    size_t universe = index.Universe().count;
+    std::vector<PlanNodePtr> included;
+    std::vector<PlanNodePtr> excluded;
+    for (const auto& [operand, negated] : operands) {
+        auto plan = Plan(*operand, index);
+        if (!negated) {
+            if (plan->op == PlanOp::kEmpty) {
+                return plan;
+            }
+            AppendFlattened(std::move(plan), PlanOp::kAnd, included);
+        } else if (plan->op != PlanOp::kEmpty) {
+            AppendFlattened(std::move(plan), PlanOp::kOr, excluded);
+        }
+    }
+
+    if (included.empty()) {
+        included.push_back(MakeNode(PlanOp::kUniverse, universe));
+    }
+    std::stable_sort(included.begin(), included.end(), [](const auto& a, const auto& b) {
+        return a->estimate < b->estimate;
+    });
+
+    PlanNodePtr result;
+    if (included.size() == 1) {
+        result = std::move(included.front());
+    } else {
+        result = MakeNode(PlanOp::kAnd, included.front()->estimate);
+        result->children = std::move(included);
+    }
+    if (excluded.empty()) {
+        return result;
+    }
+
+    auto difference = MakeNode(PlanOp::kAndNot, result->estimate);
+    difference->children.push_back(std::move(result));
+    difference->children.push_back(MakeUnion(std::move(excluded), universe));
+    return difference;
+}
+
+PlanNodePtr PlanDisjunction(const QueryNode& node, const search::IndexSegment& index) {
+    std::vector<PlanNodePtr> operands;
+    for (const auto& child : node.children) {
+        auto plan = Plan(*child, index);
+        if (plan->op != PlanOp::kEmpty) {
+            AppendFlattened(std::move(plan), PlanOp::kOr, operands);
+        }
+    }
+    return MakeUnion(std::move(operands), index.Universe().count);
+}
+
+PlanNodePtr PlanPositional(const QueryNode& node, const search::IndexSegment& index) {
+    std::vector<PlanNodePtr> terms;
+    for (const auto& child : node.children) {
+        auto plan = Plan(*child, index);
+        if (plan->op == PlanOp::kEmpty) {
+            return plan;
+        }
+        terms.push_back(std::move(plan));
+    }
+    size_t estimate = (*std::min_element(terms.begin(), terms.end(), [](const auto& a, const auto& b) {
+        return a->estimate < b->estimate;
+    }))->estimate;
+
+    PlanNodePtr plan;
+    if (!index.HasPositions()) {
+        std::stable_sort(terms.begin(), terms.end(), [](const auto& a, const auto& b) {
+            return a->estimate < b->estimate;
+        });
+        plan = MakeNode(PlanOp::kAnd, estimate);
+    } else {
+        plan = MakeNode(node.op == QueryOp::kPhrase ? PlanOp::kPhrase : PlanOp::kNear, estimate);
+        plan->distance = node.distance;
+    }
+    plan->children = std::move(terms);
+    return plan;
+}
+
+PlanNodePtr Plan(const QueryNode& node, const search::IndexSegment& index) {
+    switch (node.op) {
+        case QueryOp::kTerm: {
+            auto postings = index.Find(node.term);
+            if (!postings) {
+                return MakeNode(PlanOp::kEmpty, 0);
+            }
+            auto plan = MakeNode(PlanOp::kTerm, postings->doc_count);
+            plan->term = node.term;
+            plan->postings = *postings;
+            return plan;
+        }
+        case QueryOp::kPrefix: {
+            auto [first, last] = index.PrefixRange(node.term);
+            std::vector<PlanNodePtr> terms;
+            for (size_t term_idx = first; term_idx < last; ++term_idx) {
+                auto postings = index.Postings(term_idx);
+                auto plan = MakeNode(PlanOp::kTerm, postings.doc_count);
+                plan->term = index.Term(term_idx);
+                plan->postings = postings;
+                terms.push_back(std::move(plan));
+            }
+            return MakeUnion(std::move(terms), index.Universe().count);
+        }
+        case QueryOp::kPhrase:
+        case QueryOp::kNear:
+            return PlanPositional(node, index);
+        case QueryOp::kAnd:
+        case QueryOp::kNot:
+            return PlanConjunction(node, index);
+        case QueryOp::kOr:
+            return PlanDisjunction(node, index);
+        case QueryOp::kEmpty:
+            break;
+    }
+    return MakeNode(PlanOp::kEmpty, 0);
+}
+
+// The bitmap a leaf is stored as, if it is one
+std::optional<search::DocBitmapView> LeafBitmap(const PlanNode& plan, const search::IndexSegment& index) {
+    if (plan.op == PlanOp::kUniverse) {
+        return index.Universe();
+    }
+    if (plan.op == PlanOp::kTerm && plan.postings.bitmap.words) {
+        return plan.postings.bitmap;
+    }
+    return std::nullopt;
+}
+
+bool IsArrayLeaf(const PlanNode& plan) {
+    return plan.op == PlanOp::kTerm && !plan.postings.bitmap.words;
+}
+
+// Sizes for which decoding both lists and running an array kernel beats
+// skipping through the longer one with Advance()
+bool Comparable(size_t a, size_t b) {
+    return search::ChooseSetKernel(a, b) != search::SetKernel::kGallop;
+}
+
+bool Contains(const std::vector<const PlanNode*>& group, const PlanNode* node) {
+    return std::find(group.begin(), group.end(), node) != group.end();
+}
+
+search::DocBitmap CombineBitmaps(const std::vector<const PlanNode*>& group, bool intersect,
+                                 const search::IndexSegment& index) {
+    auto first = *LeafBitmap(*group[0], index);
+    auto combined = intersect ? search::SetAnd(first, *LeafBitmap(*group[1], index))
+                              : search::SetOr(first, *LeafBitmap(*group[1], index));
+    for (size_t i = 2; i < group.size(); ++i) {
+        auto bitmap = *LeafBitmap(*group[i], index);
+        combined = intersect ? search::SetAnd(combined.View(), bitmap) : search::SetOr(combined.View(), bitmap);
+    }
+    return combined;
+}
+
+// Sets the bit of every document of every leaf in one bitmap as wide as the
+// universe, a single pass over each list however many there are
+search::DocBitmap UnionIntoBitmap(const std::vector<const PlanNode*>& group, const search::IndexSegment& index) {
+    search::DocBitmap combined;
+    combined.words.assign(index.Universe().word_count, 0);
+    for (const auto* leaf : group) {
+        if (auto bitmap = LeafBitmap(*leaf, index)) {
+            for (uint32_t i = 0; i < bitmap->word_count; ++i) {
+                combined.words[i] |= bitmap->words[i];
+            }
+            continue;
+        }
+        search::PostingListCursor cursor(leaf->postings);
+        for (search::DocID doc_id = cursor.Doc(); doc_id != search::kNoMoreDocs; doc_id = cursor.Next()) {
+            combined.words[doc_id / 64] |= uint64_t{1} << (doc_id % 64);
+        }
+    }
+    for (uint64_t word : combined.words) {
+        combined.count += std::popcount(word);
+    }
+    return combined;
+}
+
+search::PostingList CombineArrays(const std::vector<const PlanNode*>& group, bool intersect) {
+    auto combined = search::DecodePostings(group[0]->postings);
+    for (size_t i = 1; i < group.size(); ++i) {
+        auto list = search::DecodePostings(group[i]->postings);
+        combined = intersect ? search::SetAnd(combined, list) : search::SetOr(combined, list);
+    }
+    return combined;
+}
+
+// AND / OR. Two or more bitmap operands are combined word by word up front,
+// and two or more block-encoded terms are decoded and combined with the
+// array kernels; each result takes the place of the first operand of its
+// group and the rest is iterated. An intersection only decodes lists of
+// size comparable to its rarest one; a union of kWideUnionLeaves or more
+// leaves puts all of them into one bitmap.
+search::PostingIteratorPtr BuildCombination(const PlanNode& plan, const search::IndexSegment& index) {
+    bool intersect = plan.op == PlanOp::kAnd;
+    std::vector<const PlanNode*> bitmaps;
+    std::vector<const PlanNode*> arrays;
+    for (const auto& child : plan.children) {
+        if (LeafBitmap(*child, index)) {
+            bitmaps.push_back(child.get());
+        } else if (IsArrayLeaf(*child) &&
+                   (!intersect || arrays.empty() || Comparable(arrays.front()->estimate, child->estimate))) {
+            arrays.push_back(child.get());
+        }
+    }
+    bool wide = !intersect && bitmaps.size() + arrays.size() >= kWideUnionLeaves;
+    if (wide) {
+        bitmaps.insert(bitmaps.end(), arrays.begin(), arrays.end());
+        arrays.clear();
+    }
+    if (bitmaps.size() < 2) bitmaps.clear();
+    if (arrays.size() < 2) arrays.clear();
+
+    std::vector<search::PostingIteratorPtr> children;
+    for (const auto& child : plan.children) {
+        if (!bitmaps.empty() && child.get() == bitmaps.front()) {
+            children.push_back(std::make_unique<search::BitmapIterator>(
+                wide ? UnionIntoBitmap(bitmaps, index) : CombineBitmaps(bitmaps, intersect, index)));
+        } else if (!arrays.empty() && child.get() == arrays.front()) {
+            children.push_back(std::make_unique<search::ListIterator>(CombineArrays(arrays, intersect)));
+        } else if (!Contains(bitmaps, child.get()) && !Contains(arrays, child.get())) {
+            children.push_back(search::BuildIterator(*child, index));
+        }
+    }
+
+    if (children.size() == 1) {
+        return std::move(children.front());
+    }
+    if (intersect) {
+        return std::make_unique<search::AndIterator>(std::move(children));
+    }
+    return std::make_unique<search::OrIterator>(std::move(children));
+}
+
+} // anonymous namespace
+
+namespace search {
+
+PlanNodePtr PlanQuery(const QueryNode& query, const IndexSegment& index) {
+    return Plan(query, index);
+}
+
+PostingIteratorPtr BuildIterator(const PlanNode& plan, const IndexSegment& index) {
+    switch (plan.op) {
+        case PlanOp::kTerm:
+            if (plan.postings.bitmap.words) {
+                return std::make_unique<BitmapIterator>(plan.postings.bitmap);
+            }
+            return std::make_unique<TermIterator>(plan.postings);
+        case PlanOp::kUniverse:
+            return std::make_unique<BitmapIterator>(index.Universe());
+        case PlanOp::kAnd:
+        case PlanOp::kOr:
+            return BuildCombination(plan, index);
+        case PlanOp::kAndNot: {
+            auto include = LeafBitmap(*plan.children[0], index);
+            auto exclude = LeafBitmap(*plan.children[1], index);
+            if (include && exclude) {
+                return std::make_unique<BitmapIterator>(SetAndNot(*include, *exclude));
+            }
+            const auto& minuend = *plan.children[0];
+            const auto& subtrahend = *plan.children[1];
+            if (IsArrayLeaf(minuend) && IsArrayLeaf(subtrahend) &&
+                Comparable(minuend.estimate, subtrahend.estimate)) {
+                return std::make_unique<ListIterator>(
+                    SetAndNot(DecodePostings(minuend.postings), DecodePostings(subtrahend.postings)));
+            }
+            return std::make_unique<AndNotIterator>(BuildIterator(*plan.children[0], index),
+                                                    BuildIterator(*plan.children[1], index));
+        }
+        case PlanOp::kPhrase:
+        case PlanOp::kNear: {
+            // Positions are only read for documents that have all the terms
+            std::vector<PostingListView> terms;
+            std::vector<PostingIteratorPtr> candidates;
+            for (const auto& child : plan.children) {
+                terms.push_back(child->postings);
+                candidates.push_back(BuildIterator(*child, index));
+            }
+            std::stable_sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+                return a->Cost() < b->Cost();
+            });
+            auto match = plan.op == PlanOp::kPhrase ? PositionalMatch::kPhrase : PositionalMatch::kNear;
+            return std::make_unique<PositionalIterator>(std::make_unique<AndIterator>(std::move(candidates)),
+                                                        std::move(terms), match, plan.distance);
+        }
+        case PlanOp::kEmpty:
+            break;
+    }
+    return std::make_unique<EmptyIterator>();
+}
+
+void CountPlanMatches(PlanNode& plan, const IndexSegment& index) {
+    for (auto& child : plan.children) {
+        CountPlanMatches(*child, index);
+    }
+    plan.matches = 0;
+    auto matches = BuildIterator(plan, index);
+    for (DocID doc_id = matches->Doc(); doc_id != kNoMoreDocs; doc_id = matches->Next()) {
+        plan.matches++;
+    }
+}
+
+const char* PlanOpName(PlanOp op) {
+    switch (op) {
+        case PlanOp::kEmpty: return "empty";
+        case PlanOp::kTerm: return "term";
+        case PlanOp::kUniverse: return "all";
+        case PlanOp::kAnd: return "and";
+        case PlanOp::kOr: return "or";
+        case PlanOp::kAndNot: return "and_not";
+        case PlanOp::kPhrase: return "phrase";
+        case PlanOp::kNear: return "near";
+    }
+    return "unknown";
+}
+
+} // namespace search
@@ -0,0 +1,345 @@
+#include "search/ranking.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace search {
+
+namespace {
+
+// Heap order: the better document compares less, so the worst is on top
+bool Better(const ScoredDoc& a, const ScoredDoc& b) {
+    return a.score > b.score || (a.score == b.score && a.doc_id < b.doc_id);
+}
+
+void Offer(std::vector<ScoredDoc>& heap, size_t k, ScoredDoc doc) {
+    if (heap.size() < k) {
+        heap.push_back(doc);
+        std::push_heap(heap.begin(), heap.end(), Better);
+    } else if (k > 0 && Better(doc, heap.front())) {
+        std::pop_heap(heap.begin(), heap.end(), Better);
+        heap.back() = doc;
+        std::push_heap(heap.begin(), heap.end(), Better);
+    }
+}
+
+void CollectTerms(const PlanNode& plan, std::vector<const PlanNode*>& terms) {
+    if (plan.op == PlanOp::kTerm) {
+        bool seen = std::any_of(terms.begin(), terms.end(),
+                                [&](const PlanNode* term) { return term->term == plan.term; });
+        if (!seen) {
+            terms.push_back(&plan);
+        }
+        return;
+    }
+    size_t scored = plan.op == PlanOp::kAndNot ? 1 : plan.children.size();
+    for (size_t i = 0; i < scored; ++i) {
+        CollectTerms(*plan.children[i], terms);
+    }
+}
+
+double TermIdf(const IndexSegment& index, const PlanNode& term, const Bm25Stats* stats) {
+    if (!stats) {
+        return Bm25Idf(index.DocCount(), term.postings.doc_count);
+    }
+    auto doc_freq = stats->doc_freqs.find(term.term);
+    return Bm25Idf(stats->doc_count,
+                   doc_freq != stats->doc_freqs.end() ? doc_freq->second : term.postings.doc_count);
+}
+
+// A posting list cursor that also knows its term's score bounds. Shallow
+// lookups of the block bound only read the skip table, so a skipped block
+// is never decoded.
+class BlockMaxCursor {
+public:
+    // The stored bounds are multiplied by bound_scale
+    BlockMaxCursor(const PostingListView& view, double idf, double bound_scale, size_t term)
+        : view_(view), idf_(idf), bound_scale_(bound_scale), term_(term) {
+        if (view_.bitmap.words) {
+            doc_ = NextSetBit(0);
+        } else {
+            cursor_.emplace(view_);
+            doc_ = cursor_->Doc();
+        }
+    }
+
+    DocID Doc() const { return doc_; }
+    double Idf() const { return idf_; }
+    size_t Term() const { return term_; }
+    double MaxScore() const { return view_.max_score * bound_scale_; }
+
+    DocID Advance(DocID target) {
+        if (doc_ >= target) {
+            return doc_;
+        }
+        doc_ = cursor_ ? cursor_->Advance(target) : NextSetBit(target);
+        return doc_;
+    }
+
+    uint32_t Freq() const {
+        if (cursor_) {
+            return view_.freqs[cursor_->Index()];
+        }
+        return view_.freqs[BitmapRank(view_.bitmap, view_.bitmap_ranks, doc_)];
+    }
+
+    // Bound of the block holding target, which must not decrease between
+    // calls; BlockEnd() is then the last docid that block covers
+    double BlockMaxScore(DocID target) {
+        if (cursor_) {
+            while (block_ < view_.block_count && view_.skips[block_].max_doc_id < target) {
+                ++block_;
+            }
+            if (block_ == view_.block_count) {
+                block_end_ = kNoMoreDocs - 1;
+                return 0;
+            }
+            block_end_ = view_.skips[block_].max_doc_id;
+            return view_.block_max_scores[block_] * bound_scale_;
+        }
+        size_t block = target / kBitmapBlockDocs;
+        block_end_ = static_cast<DocID>(std::min<uint64_t>((block + 1) * kBitmapBlockDocs - 1, kNoMoreDocs - 1));
+        size_t block_count = (view_.bitmap.word_count + kBitmapRankWords - 1) / kBitmapRankWords;
+        return block < block_count ? view_.block_max_scores[block] * bound_scale_ : 0;
+    }
+
+    DocID BlockEnd() const { return block_end_; }
+
+private:
+    PostingListView view_;
+    double idf_;
+    double bound_scale_;
+    size_t term_;
+    std::optional<PostingListCursor> cursor_; // block lists only
+    DocID doc_ = kNoMoreDocs;
+    uint32_t block_ = 0;
+    DocID block_end_ = 0;
+
+    DocID NextSetBit(DocID from) const {
+        size_t word = from / 64;
+        if (word >= view_.bitmap.word_count) {
+            return kNoMoreDocs;
+        }
+        uint64_t bits = view_.bitmap.words[word] & (~uint64_t{0} << (from % 64));
+        while (bits == 0) {
+            if (++word == view_.bitmap.word_count) {
+                return kNoMoreDocs;
+            }
+            bits = view_.bitmap.words[word];
+        }
+        return static_cast<DocID>(word * 64 + std::countr_zero(bits));
+    }
+};
+
+} // anonymous namespace
+
+double Bm25Idf(size_t doc_count, size_t doc_freq) {
+    double n = static_cast<double>(doc_count);
+    double df = static_cast<double>(doc_freq);
+    return std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+}
+
+double Bm25TermWeight(uint32_t tf, uint32_t doc_length, double average_length) {
+    double length_norm = 1.0 - kBm25B;
+    if (average_length > 0) {
+        length_norm += kBm25B * doc_length / average_length;
+    }
+    return tf * (kBm25K1 + 1) / (tf + kBm25K1 * length_norm);
+}
+
+size_t LiveDocFreq(const PostingListView& postings, const DocBitmapView& deleted) {
+    size_t doc_freq = postings.doc_count;
+    if (deleted.count == 0) {
+        return doc_freq;
+    }
+    if (postings.bitmap.words) {
+        size_t words = std::min(postings.bitmap.word_count, deleted.word_count);
+        for (size_t word = 0; word < words; ++word) {
+            doc_freq -= std::popcount(postings.bitmap.words[word] & deleted.words[word]);
+        }
+        return doc_freq;
+    }
+    PostingListCursor cursor(postings);
+    for (size_t word = 0; word < deleted.word_count && !cursor.AtEnd(); ++word) {
+        for (uint64_t bits = deleted.words[word]; bits != 0; bits &= bits - 1) {
+            auto doc_id = static_cast<DocID>(word * 64 + std::countr_zero(bits));
+            doc_freq -= cursor.Advance(doc_id) == doc_id;
+        }
+    }
+    return doc_freq;
+}
+
+TermFrequencyCursor::TermFrequencyCursor(const PostingListView& view) : view_(view) {
+    if (!view_.bitmap.words) {
+        cursor_.emplace(view_);
+    }
+}
+
+uint32_t TermFrequencyCursor::Freq(DocID doc_id) {
+    if (!view_.freqs) {
+        return 0;
+    }
+    if (view_.bitmap.words) {
+        if (!BitmapContains(view_.bitmap, doc_id)) {
+            return 0;
+        }
+        return view_.freqs[BitmapRank(view_.bitmap, view_.bitmap_ranks, doc_id)];
+    }
+    if (cursor_->Advance(doc_id) != doc_id) {
+        return 0;
+    }
+    return view_.freqs[cursor_->Index()];
+}
+
+Bm25Ranker::Bm25Ranker(const IndexSegment& index, const PlanNode& plan, size_t k, const Bm25Stats* stats)
+    : index_(index), average_length_(stats ? stats->average_length : index.AverageDocLength()), k_(k) {
+    std::vector<const PlanNode*> terms;
+    CollectTerms(plan, terms);
+    for (const auto* term : terms) {
+        terms_.push_back({TermFrequencyCursor(term->postings), TermIdf(index, *term, stats)});
+    }
+    heap_.reserve(std::min<size_t>(k_, 1024));
+}
+
+void Bm25Ranker::Add(DocID doc_id) {
+    if (k_ == 0) {
+        return;
+    }
+
+    double score = 0;
+    for (auto& term : terms_) {
+        uint32_t tf = term.freqs.Freq(doc_id);
+        if (tf > 0) {
+            score += term.idf * Bm25TermWeight(tf, index_.DocLength(doc_id), average_length_);
+        }
+    }
+    Offer(heap_, k_, {doc_id, score});
+}
+
+std::vector<ScoredDoc> Bm25Ranker::Finish() {
+    std::sort_heap(heap_.begin(), heap_.end(), Better);
+    return std::move(heap_);
+}
+
+bool IsTermDisjunction(const PlanNode& plan) {
+    if (plan.op == PlanOp::kTerm) {
+        return true;
+    }
+    return plan.op == PlanOp::kOr &&
+           std::all_of(plan.children.begin(), plan.children.end(),
+                       [](const auto& child) { return child->op == PlanOp::kTerm; });
+}
+
+PrunedRanking RankDisjunction(const IndexSegment& index, const PlanNode& plan, size_t k,
+                              const DocBitmapView& deleted, const Bm25Stats* stats) {
+    PrunedRanking ranking;
+    if (k == 0) {
+        return ranking;
+    }
+    std::vector<const PlanNode*> terms;
+    CollectTerms(plan, terms);
+
+    // The stored bounds were computed with the segment's own statistics.
+    // Under stats a term weighs idf / segment idf times as much, and a longer
+    // average length raises the tf part by at most the ratio of the averages.
+    double average_length = stats ? stats->average_length : index.AverageDocLength();
+    double length_scale = 1;
+    if (stats && index.AverageDocLength() > 0) {
+        length_scale = std::max(1.0, average_length / index.AverageDocLength());
+    }
+    std::vector<BlockMaxCursor> cursors;
+    cursors.reserve(terms.size());
+    for (size_t i = 0; i < terms.size(); ++i) {
+        double idf = TermIdf(index, *terms[i], stats);
+        double bound_scale = stats ? idf / Bm25Idf(index.DocCount(), terms[i]->postings.doc_count) * length_scale : 1;
+        cursors.emplace_back(terms[i]->postings, idf, bound_scale, i);
+    }
+    std::vector<BlockMaxCursor*> order;
+    for (auto& cursor : cursors) {
+        order.push_back(&cursor);
+    }
+
+    std::vector<double> contributions(terms.size(), 0.0);
+    std::vector<ScoredDoc> heap;
+    heap.reserve(std::min<size_t>(k, 1024));
+    auto by_doc = [](const BlockMaxCursor* a, const BlockMaxCursor* b) { return a->Doc() < b->Doc(); };
+
+    while (true) {
+        // Until k documents are kept every match is a candidate
+        double threshold = heap.size() < k ? -1.0 : heap.front().score;
+        std::sort(order.begin(), order.end(), by_doc);
+
+        // The pivot is the first cursor at which the list bounds add up to
+        // more than the threshold; no docid before its own can make it
+        size_t pivot = order.size();
+        double bound = 0;
+        for (size_t i = 0; i < order.size() && order[i]->Doc() != kNoMoreDocs; ++i) {
+            bound += order[i]->MaxScore();
+            if (bound > threshold) {
+                pivot = i;
+                break;
+            }
+        }
+        if (pivot == order.size()) {
+            break;
+        }
+        DocID doc_id = order[pivot]->Doc();
+        while (pivot + 1 < order.size() && order[pivot + 1]->Doc() == doc_id) {
+            ++pivot;
+        }
+
+        double block_bound = 0;
+        DocID skip_end = kNoMoreDocs - 1;
+        for (size_t i = 0; i <= pivot; ++i) {
+            block_bound += order[i]->BlockMaxScore(doc_id);
+            skip_end = std::min(skip_end, order[i]->BlockEnd());
+        }
+
+        if (block_bound <= threshold) {
+            // Nothing up to the end of the shallowest block, or up to the next
+            // list that was not counted, can beat the threshold
+            if (pivot + 1 < order.size()) {
+                skip_end = std::min(skip_end, order[pivot + 1]->Doc() - 1);
+            }
+            for (size_t i = 0; i <= pivot; ++i) {
+                order[i]->Advance(skip_end + 1);
+            }
+        } else if (order[0]->Doc() != doc_id) {
+            for (size_t i = 0; i < pivot && order[i]->Doc() < doc_id; ++i) {
+                order[i]->Advance(doc_id);
+            }
+        } else if (BitmapContains(deleted, doc_id)) {
+            for (size_t i = 0; i <= pivot; ++i) {
+                order[i]->Advance(doc_id + 1);
+            }
+        } else {
+            // Summed in term order, so scores match Bm25Ranker bit for bit
+            uint32_t doc_length = index.DocLength(doc_id);
+            for (size_t i = 0; i <= pivot; ++i) {
+                contributions[order[i]->Term()] =
+                    order[i]->Idf() * Bm25TermWeight(order[i]->Freq(), doc_length, average_length);
+            }
+            double score = 0;
+            for (double& contribution : contributions) {
+                if (contribution > 0) {
+                    score += contribution;
+                    contribution = 0;
+                }
+            }
+            Offer(heap, k, {doc_id, score});
+            ranking.scored++;
+            for (size_t i = 0; i <= pivot; ++i) {
+                order[i]->Advance(doc_id + 1);
+            }
+        }
+    }
+
+    // The threshold never rose above -1 unless the heap filled up
+    ranking.exact = heap.size() < k;
+    std::sort_heap(heap.begin(), heap.end(), Better);
+    ranking.hits = std::move(heap);
+    return ranking;
+}
+
+} // namespace search
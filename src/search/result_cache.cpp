@@ -0,0 +1,143 @@
+#include "search/result_cache.hpp"
+#include "containers/frequency_sketch.hpp"
+#include "containers/hash_map.hpp"
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <string_view>
+
+namespace search {
+
+namespace {
+
+// Rough size of a cached result apart from its key and docids, used to size
+// the frequency sketches and charge entries against the budget
+constexpr size_t kEntryOverheadBytes = 128;
+constexpr size_t kExpectedEntryBytes = 1024;
+
+size_t EntryBytes(const std::string& key, const SearchResult& result) {
+    return kEntryOverheadBytes + key.size() + result.docs.capacity() * sizeof(DocID) +
+           result.scores.capacity() * sizeof(double);
+}
+
+// FNV-1a leaves the high bits poorly mixed; shards and sketch rows need them
+uint64_t KeyHash(const std::string& key) {
+    uint64_t hash = containers::Hasher<std::string>()(key);
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+} // anonymous namespace
+
+struct ResultCache::Shard {
+    struct Entry {
+        std::string key;
+        uint64_t hash;
+        uint64_t generation;
+        std::shared_ptr<const SearchResult> result;
+        size_t bytes;
+    };
+    using EntryList = std::list<Entry>;
+
+    explicit Shard(size_t capacity) : sketch(capacity / kExpectedEntryBytes), capacity_bytes(capacity) {}
+
+    void Erase(EntryList::iterator it) {
+        bytes -= it->bytes;
+        index.Erase(std::string_view(it->key));
+        lru.erase(it);
+    }
+
+    std::mutex mutex;
+    EntryList lru; // most recently used first
+    containers::HashMap<std::string_view, EntryList::iterator> index; // keys live in lru
+    containers::FrequencySketch sketch;
+    size_t capacity_bytes;
+    size_t bytes = 0;
+    ResultCacheStats stats;
+};
+
+ResultCache::ResultCache(size_t capacity_bytes, size_t shard_count) : capacity_bytes_(capacity_bytes) {
+    shard_count = std::max<size_t>(1, shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>(capacity_bytes / shard_count));
+    }
+}
+
+ResultCache::~ResultCache() = default;
+
+ResultCache::Shard& ResultCache::ShardFor(uint64_t hash) {
+    return *shards_[(hash >> 48) % shards_.size()];
+}
+
+std::shared_ptr<const SearchResult> ResultCache::Find(const std::string& key, uint64_t generation) {
+    uint64_t hash = KeyHash(key);
+    auto& shard = ShardFor(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.sketch.Record(hash);
+
+    auto* found = shard.index.Find(std::string_view(key));
+    if (!found) {
+        shard.stats.misses++;
+        return nullptr;
+    }
+    auto it = *found;
+    if (it->generation != generation) {
+        shard.Erase(it);
+        shard.stats.invalidations++;
+        shard.stats.misses++;
+        return nullptr;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it);
+    shard.stats.hits++;
+    return it->result;
+}
+
+void ResultCache::Insert(const std::string& key, uint64_t generation, std::shared_ptr<const SearchResult> result) {
+    uint64_t hash = KeyHash(key);
+    size_t bytes = EntryBytes(key, *result);
+    auto& shard = ShardFor(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // Another thread may have computed the same result meanwhile
+    if (auto* found = shard.index.Find(std::string_view(key))) {
+        shard.Erase(*found);
+    }
+    if (bytes > shard.capacity_bytes) {
+        shard.stats.rejections++;
+        return;
+    }
+    if (shard.bytes + bytes > shard.capacity_bytes &&
+        shard.sketch.Estimate(hash) <= shard.sketch.Estimate(shard.lru.back().hash)) {
+        shard.stats.rejections++;
+        return;
+    }
+    while (shard.bytes + bytes > shard.capacity_bytes) {
+        shard.Erase(std::prev(shard.lru.end()));
+        shard.stats.evictions++;
+    }
+
+    shard.lru.push_front({key, hash, generation, std::move(result), bytes});
+    shard.index[std::string_view(shard.lru.front().key)] = shard.lru.begin();
+    shard.bytes += bytes;
+    shard.stats.insertions++;
+}
+
+ResultCacheStats ResultCache::Stats() const {
+    ResultCacheStats total;
+    total.capacity_bytes = capacity_bytes_;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total.hits += shard->stats.hits;
+        total.misses += shard->stats.misses;
+        total.insertions += shard->stats.insertions;
+        total.evictions += shard->stats.evictions;
+        total.rejections += shard->stats.rejections;
+        total.invalidations += shard->stats.invalidations;
+        total.entries += shard->lru.size();
+        total.bytes += shard->bytes;
+    }
+    return total;
+}
+
+} // namespace search
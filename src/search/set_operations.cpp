@@ -0,0 +1,317 @@
+#include "search/set_operations.hpp"
+#include "search/set_operations_simd.hpp"
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SEARCH_X86_SIMD 1
+#endif
+
+namespace {
+
+using search::DocID;
+using search::PostingList;
+using search::SetKernel;
+
+// First position >= from whose value is >= target. Doubles the step until
+// it overshoots, then binary-searches the last step.
+size_t Gallop(const PostingList& list, size_t from, DocID target) {
+    size_t lo = from, hi = from, step = 1;
+    while (hi < list.size() && list[hi] < target) {
+        lo = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    hi = std::min(hi, list.size());
+    return std::lower_bound(list.begin() + lo, list.begin() + hi, target) - list.begin();
+}
+
+PostingList GallopAnd(const PostingList& a, const PostingList& b) {
+    const PostingList& shorter = a.size() <= b.size() ? a : b;
+    const PostingList& longer = a.size() <= b.size() ? b : a;
+    PostingList result;
+    result.reserve(shorter.size());
+    size_t pos = 0;
+    for (DocID doc_id : shorter) {
+        pos = Gallop(longer, pos, doc_id);
+        if (pos == longer.size()) {
+            break;
+        }
+        if (longer[pos] == doc_id) {
+            result.push_back(doc_id);
+        }
+    }
+    return result;
+}
+
+PostingList GallopOr(const PostingList& a, const PostingList& b) {
+    const PostingList& shorter = a.size() <= b.size() ? a : b;
+    const PostingList& longer = a.size() <= b.size() ? b : a;
+    PostingList result;
+    result.reserve(a.size() + b.size());
+    size_t pos = 0;
+    for (DocID doc_id : shorter) {
+        size_t next = Gallop(longer, pos, doc_id);
+        result.insert(result.end(), longer.begin() + pos, longer.begin() + next);
+        result.push_back(doc_id);
+        pos = next < longer.size() && longer[next] == doc_id ? next + 1 : next;
+    }
+    result.insert(result.end(), longer.begin() + pos, longer.end());
+    return result;
+}
+
+PostingList GallopAndNot(const PostingList& a, const PostingList& b) {
+    PostingList result;
+    result.reserve(a.size());
+    size_t pos = 0;
+    if (a.size() <= b.size()) {
+        for (DocID doc_id : a) {
+            pos = Gallop(b, pos, doc_id);
+            if (pos == b.size() || b[pos] != doc_id) {
+                result.push_back(doc_id);
+            }
+        }
+        return result;
+    }
+    // Copy the runs of a between consecutive elements of b
+    for (DocID doc_id : b) {
+        size_t next = Gallop(a, pos, doc_id);
+        result.insert(result.end(), a.begin() + pos, a.begin() + next);
+        pos = next < a.size() && a[next] == doc_id ? next + 1 : next;
+    }
+    result.insert(result.end(), a.begin() + pos, a.end());
+    return result;
+}
+
+#ifdef SEARCH_X86_SIMD
+using SimdKernel = size_t (*)(const DocID*, size_t, const DocID*, size_t, DocID*);
+
+PostingList RunSimd(SimdKernel kernel, const PostingList& a, const PostingList& b, size_t max_size) {
+    PostingList result(max_size + search::simd::kSimdSlack);
+    result.resize(kernel(a.data(), a.size(), b.data(), b.size(), result.data()));
+    return result;
+}
+#endif
+
+SetKernel DetectSimdKernel() {
+#ifdef SEARCH_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SetKernel::kAvx2;
+    if (__builtin_cpu_supports("sse4.2")) return SetKernel::kSse42;
+#endif
+    return SetKernel::kMerge;
+}
+
+SetKernel Supported(SetKernel kernel) {
+    if (kernel >= SetKernel::kSse42 && kernel > search::BestSimdKernel()) {
+        return SetKernel::kMerge;
+    }
+    return kernel;
+}
+
+} // anonymous namespace
+
+namespace search {
+
+SetKernel BestSimdKernel() {
+    static const SetKernel kernel = DetectSimdKernel();
+    return kernel;
+}
+
+SetKernel ChooseSetKernel(size_t a_size, size_t b_size) {
+    size_t shorter = std::min(a_size, b_size);
+    size_t longer = std::max(a_size, b_size);
+    if (longer >= shorter * kGallopRatio) {
+        return SetKernel::kGallop;
+    }
+    return BestSimdKernel();
+}
+
+PostingList SetAnd(const PostingList& a, const PostingList& b) {
+    return SetAnd(a, b, ChooseSetKernel(a.size(), b.size()));
+}
+
+PostingList SetOr(const PostingList& a, const PostingList& b) {
+    return SetOr(a, b, ChooseSetKernel(a.size(), b.size()));
+}
+
+PostingList SetAndNot(const PostingList& a, const PostingList& b) {
+    return SetAndNot(a, b, ChooseSetKernel(a.size(), b.size()));
+}
+
+PostingList SetAnd(const PostingList& a, const PostingList& b, SetKernel kernel) {
+    switch (Supported(kernel)) {
+        case SetKernel::kGallop:
+            return GallopAnd(a, b);
+#ifdef SEARCH_X86_SIMD
+        case SetKernel::kSse42:
+            return RunSimd(simd::AndSse42, a, b, std::min(a.size(), b.size()));
+        case SetKernel::kAvx2:
+            return RunSimd(simd::AndAvx2, a, b, std::min(a.size(), b.size()));
+#endif
+        default:
+            return SetAnd<DocID>(a, b);
+    }
+}
+
+PostingList SetOr(const PostingList& a, const PostingList& b, SetKernel kernel) {
+    switch (Supported(kernel)) {
+        case SetKernel::kGallop:
+            return GallopOr(a, b);
+#ifdef SEARCH_X86_SIMD
+        case SetKernel::kSse42:
+            return RunSimd(simd::OrSse42, a, b, a.size() + b.size());
+        case SetKernel::kAvx2:
+            return RunSimd(simd::OrAvx2, a, b, a.size() + b.size());
+#endif
+        default:
+            return SetOr<DocID>(a, b);
+    }
+}
+
+PostingList SetAndNot(const PostingList& a, const PostingList& b, SetKernel kernel) {
+    switch (Supported(kernel)) {
+        case SetKernel::kGallop:
+            return GallopAndNot(a, b);
+#ifdef SEARCH_X86_SIMD
+        case SetKernel::kSse42:
+            return RunSimd(simd::AndNotSse42, a, b, a.size());
+        case SetKernel::kAvx2:
+            return RunSimd(simd::AndNotAvx2, a, b, a.size());
+#endif
+        default:
+            return SetAndNot<DocID>(a, b);
+    }
+}
+
+std::vector<uint32_t> BuildBitmapRanks(const DocBitmapView& bitmap) {
+    std::vector<uint32_t> ranks;
+    ranks.reserve(bitmap.word_count / kBitmapRankWords + 1);
+    uint32_t rank = 0;
+    for (uint32_t i = 0; i < bitmap.word_count; ++i) {
+        if (i % kBitmapRankWords == 0) {
+            ranks.push_back(rank);
+        }
+        rank += std::popcount(bitmap.words[i]);
+    }
+    return ranks;
+}
+
+uint32_t BitmapRank(const DocBitmapView& bitmap, const uint32_t* ranks, DocID doc_id) {
+    size_t word = std::min<size_t>(doc_id / 64, bitmap.word_count);
+    size_t block = word / kBitmapRankWords;
+    // Past the last word only the total is left
+    if (word == bitmap.word_count && word % kBitmapRankWords == 0) {
+        return bitmap.count;
+    }
+    uint32_t rank = ranks[block];
+    for (size_t i = block * kBitmapRankWords; i < word; ++i) {
+        rank += std::popcount(bitmap.words[i]);
+    }
+    if (word < bitmap.word_count) {
+        rank += std::popcount(bitmap.words[word] & ((uint64_t{1} << (doc_id % 64)) - 1));
+    }
+    return rank;
+}
+
+PostingList SetAnd(const PostingList& a, const DocBitmapView& b) {
+    PostingList result;
+    result.reserve(std::min<size_t>(a.size(), b.count));
+    for (DocID doc_id : a) {
+        if (BitmapContains(b, doc_id)) {
+            result.push_back(doc_id);
+        }
+    }
+    return result;
+}
+
+PostingList SetAndNot(const PostingList& a, const DocBitmapView& b) {
+    PostingList result;
+    result.reserve(a.size());
+    for (DocID doc_id : a) {
+        if (!BitmapContains(b, doc_id)) {
+            result.push_back(doc_id);
+        }
+    }
+    return result;
+}
+
+DocBitmap SetOr(const DocBitmapView& a, const PostingList& b) {
+    DocBitmap result;
+    size_t word_count = b.empty() ? a.word_count : std::max<size_t>(a.word_count, b.back() / 64 + 1);
+    result.words.assign(word_count, 0);
+    std::copy(a.words, a.words + a.word_count, result.words.begin());
+    result.count = a.count;
+    for (DocID doc_id : b) {
+        uint64_t& word = result.words[doc_id / 64];
+        uint64_t bit = uint64_t{1} << (doc_id % 64);
+        result.count += (word & bit) == 0;
+        word |= bit;
+    }
+    return result;
+}
+
+DocBitmap SetAnd(const DocBitmapView& a, const DocBitmapView& b) {
+    DocBitmap result;
+    result.words.resize(std::min(a.word_count, b.word_count));
+    for (size_t i = 0; i < result.words.size(); ++i) {
+        result.words[i] = a.words[i] & b.words[i];
+        result.count += std::popcount(result.words[i]);
+    }
+    return result;
+}
+
+DocBitmap SetOr(const DocBitmapView& a, const DocBitmapView& b) {
+    const DocBitmapView& longer = a.word_count >= b.word_count ? a : b;
+    const DocBitmapView& shorter = a.word_count >= b.word_count ? b : a;
+    DocBitmap result;
+    result.words.resize(longer.word_count);
+    for (size_t i = 0; i < result.words.size(); ++i) {
+        result.words[i] = longer.words[i] | (i < shorter.word_count ? shorter.words[i] : 0);
+        result.count += std::popcount(result.words[i]);
+    }
+    return result;
+}
+
+DocBitmap SetAndNot(const DocBitmapView& a, const DocBitmapView& b) {
+    DocBitmap result;
+    result.words.resize(a.word_count);
+    for (size_t i = 0; i < result.words.size(); ++i) {
+        result.words[i] = a.words[i] & ~(i < b.word_count ? b.words[i] : 0);
+        result.count += std::popcount(result.words[i]);
+    }
+    return result;
+}
+
+size_t CountAnd(const DocBitmapView& a, const DocBitmapView& b) {
+    size_t count = 0;
+    for (size_t i = 0, n = std::min(a.word_count, b.word_count); i < n; ++i) {
+        count += std::popcount(a.words[i] & b.words[i]);
+    }
+    return count;
+}
+
+DocBitmap ToBitmap(const PostingList& list) {
+    DocBitmap result;
+    if (!list.empty()) {
+        result.words.assign(list.back() / 64 + 1, 0);
+    }
+    for (DocID doc_id : list) {
+        result.words[doc_id / 64] |= uint64_t{1} << (doc_id % 64);
+    }
+    result.count = static_cast<uint32_t>(list.size());
+    return result;
+}
+
+PostingList ToPostingList(const DocBitmapView& bitmap) {
+    PostingList result;
+    result.reserve(bitmap.count);
+    for (uint32_t i = 0; i < bitmap.word_count; ++i) {
+        for (uint64_t bits = bitmap.words[i]; bits != 0; bits &= bits - 1) {
+            result.push_back(static_cast<DocID>(i * 64 + std::countr_zero(bits)));
+        }
+    }
+    return result;
+}
+
+} // namespace search
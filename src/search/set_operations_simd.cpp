@@ -0,0 +1,368 @@
+#include "search/set_operations_simd.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <immintrin.h>
+
+// Intersection and difference compare a block of a against every lane of a
+// block of b (all rotations of b) and compress the selected lanes of a to
+// the output with a shuffle from a lookup table. Union merges two sorted
+// vectors with a min/max network, emits the lower half and drops lanes equal
+// to their predecessor. Leftovers shorter than a vector go through the scalar
+// tails below.
+
+namespace {
+
+using search::DocID;
+
+constexpr std::array<std::array<uint8_t, 16>, 16> MakeSseCompressTable() {
+    std::array<std::array<uint8_t, 16>, 16> table{};
+    for (int mask = 0; mask < 16; ++mask) {
+        int out = 0;
+        for (int lane = 0; lane < 4; ++lane) {
+            if (mask & (1 << lane)) {
+                for (int byte = 0; byte < 4; ++byte) {
+                    table[mask][out * 4 + byte] = static_cast<uint8_t>(lane * 4 + byte);
+                }
+                ++out;
+            }
+        }
+        for (int byte = out * 4; byte < 16; ++byte) {
+            table[mask][byte] = 0x80;
+        }
+    }
+    return table;
+}
+
+constexpr std::array<std::array<uint32_t, 8>, 256> MakeAvx2CompressTable() {
+    std::array<std::array<uint32_t, 8>, 256> table{};
+    for (int mask = 0; mask < 256; ++mask) {
+        int out = 0;
+        for (int lane = 0; lane < 8; ++lane) {
+            if (mask & (1 << lane)) {
+                table[mask][out++] = static_cast<uint32_t>(lane);
+            }
+        }
+    }
+    return table;
+}
+
+// Lane shuffles that keep the lanes whose bit is set in the index, packed
+// to the front
+alignas(16) constexpr auto kSseCompress = MakeSseCompressTable();
+alignas(32) constexpr auto kAvx2Compress = MakeAvx2CompressTable();
+
+size_t AndTail(const DocID* a, size_t i, size_t na, const DocID* b, size_t j, size_t nb,
+               DocID* out, size_t len) {
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            out[len++] = a[i];
+            ++i;
+            ++j;
+        }
+    }
+    return len;
+}
+
+size_t AndNotTail(const DocID* a, size_t i, size_t na, const DocID* b, size_t j, size_t nb,
+                  DocID* out, size_t len) {
+    for (; i < na; ++i) {
+        while (j < nb && b[j] < a[i]) {
+            ++j;
+        }
+        if (j == nb || a[i] < b[j]) {
+            out[len++] = a[i];
+        }
+    }
+    return len;
+}
+
+// Merges two sorted runs onto out, skipping values equal to the last one
+// written; everything already in out must be <= both runs.
+size_t OrTail(const DocID* a, size_t i, size_t na, const DocID* b, size_t j, size_t nb,
+              DocID* out, size_t len) {
+    while (i < na || j < nb) {
+        DocID value;
+        if (j == nb || (i < na && a[i] < b[j])) {
+            value = a[i++];
+        } else if (i == na || b[j] < a[i]) {
+            value = b[j++];
+        } else {
+            value = a[i++];
+            ++j;
+        }
+        if (len == 0 || out[len - 1] != value) {
+            out[len++] = value;
+        }
+    }
+    return len;
+}
+
+// Union leftovers: the pending upper half of the merge network plus the
+// unread parts of both inputs.
+size_t OrLeftovers(const DocID* pending, size_t pending_len, const DocID* a, size_t i, size_t na,
+                   const DocID* b, size_t j, size_t nb, DocID* out, size_t len) {
+    DocID merged[search::simd::kSimdSlack * 2];
+    if (na - i <= search::simd::kSimdSlack) {
+        size_t merged_len = OrTail(pending, 0, pending_len, a, i, na, merged, 0);
+        return OrTail(merged, 0, merged_len, b, j, nb, out, len);
+    }
+    size_t merged_len = OrTail(pending, 0, pending_len, b, j, nb, merged, 0);
+    return OrTail(merged, 0, merged_len, a, i, na, out, len);
+}
+
+// ---- SSE4.2, 4 lanes ----
+
+__attribute__((target("sse4.2"))) inline __m128i LoadSse(const DocID* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// Lanes of a that are equal to any lane of b
+__attribute__((target("sse4.2"))) inline int MatchSse(__m128i a, __m128i b) {
+    __m128i m01 = _mm_or_si128(_mm_cmpeq_epi32(a, b),
+                               _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1))));
+    __m128i m23 = _mm_or_si128(_mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))),
+                               _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3))));
+    return _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(m01, m23)));
+}
+
+__attribute__((target("sse4.2"))) inline size_t StoreLanesSse(__m128i v, int mask, DocID* out) {
+    __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(kSseCompress[mask].data()));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(v, shuffle));
+    return std::popcount(static_cast<unsigned>(mask));
+}
+
+// lo receives the four smallest of a and b, hi the four largest, both sorted
+__attribute__((target("sse4.2"))) inline void MergeSse(__m128i a, __m128i b, __m128i& lo, __m128i& hi) {
+    __m128i tmp = _mm_min_epu32(a, b);
+    hi = _mm_max_epu32(a, b);
+    for (int stage = 1; stage < 4; ++stage) {
+        tmp = _mm_shuffle_epi32(tmp, _MM_SHUFFLE(0, 3, 2, 1));
+        lo = _mm_min_epu32(tmp, hi);
+        hi = _mm_max_epu32(tmp, hi);
+        tmp = lo;
+    }
+    lo = _mm_shuffle_epi32(tmp, _MM_SHUFFLE(0, 3, 2, 1));
+}
+
+__attribute__((target("sse4.2"))) inline size_t StoreUniqueSse(__m128i last, __m128i v, DocID* out) {
+    __m128i prev = _mm_alignr_epi8(v, last, 12);
+    int dups = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(prev, v)));
+    return StoreLanesSse(v, ~dups & 0xF, out);
+}
+
+// ---- AVX2, 8 lanes ----
+
+__attribute__((target("avx2"))) inline __m256i LoadAvx2(const DocID* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+// Lane i takes lane i + 1
+__attribute__((target("avx2"))) inline __m256i RotateAvx2(__m256i v) {
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0));
+}
+
+__attribute__((target("avx2"))) inline int MatchAvx2(__m256i a, __m256i b) {
+    __m256i matches = _mm256_cmpeq_epi32(a, b);
+    for (int rotation = 1; rotation < 8; ++rotation) {
+        b = RotateAvx2(b);
+        matches = _mm256_or_si256(matches, _mm256_cmpeq_epi32(a, b));
+    }
+    return _mm256_movemask_ps(_mm256_castsi256_ps(matches));
+}
+
+__attribute__((target("avx2"))) inline size_t StoreLanesAvx2(__m256i v, int mask, DocID* out) {
+    __m256i permute = _mm256_load_si256(reinterpret_cast<const __m256i*>(kAvx2Compress[mask].data()));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(v, permute));
+    return std::popcount(static_cast<unsigned>(mask));
+}
+
+__attribute__((target("avx2"))) inline void MergeAvx2(__m256i a, __m256i b, __m256i& lo, __m256i& hi) {
+    __m256i tmp = _mm256_min_epu32(a, b);
+    hi = _mm256_max_epu32(a, b);
+    for (int stage = 1; stage < 8; ++stage) {
+        tmp = RotateAvx2(tmp);
+        lo = _mm256_min_epu32(tmp, hi);
+        hi = _mm256_max_epu32(tmp, hi);
+        tmp = lo;
+    }
+    lo = RotateAvx2(tmp);
+}
+
+__attribute__((target("avx2"))) inline size_t StoreUniqueAvx2(__m256i last, __m256i v, DocID* out) {
+    __m256i shift = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+    __m256i prev = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(v, shift),
+                                      _mm256_permutevar8x32_epi32(last, shift), 0x01);
+    int dups = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(prev, v)));
+    return StoreLanesAvx2(v, ~dups & 0xFF, out);
+}
+
+} // anonymous namespace
+
+namespace search::simd {
+
+__attribute__((target("sse4.2")))
+size_t AndSse42(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out) {
+    size_t i = 0, j = 0, len = 0;
+    if (na >= 4 && nb >= 4) {
+        __m128i va = LoadSse(a);
+        __m128i vb = LoadSse(b);
+        while (true) {
+            len += StoreLanesSse(va, MatchSse(va, vb), out + len);
+            DocID a_max = a[i + 3];
+            DocID b_max = b[j + 3];
+            if (a_max <= b_max) {
+                i += 4;
+                if (i + 4 > na) break;
+                va = LoadSse(a + i);
+            }
+            if (b_max <= a_max) {
+                j += 4;
+                if (j + 4 > nb) break;
+                vb = LoadSse(b + j);
+            }
+        }
+    }
+    return AndTail(a, i, na, b, j, nb, out, len);
+}
+
+__attribute__((target("sse4.2")))
+size_t AndNotSse42(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out) {
+    size_t i = 0, j = 0, len = 0;
+    while (i + 4 <= na && j + 4 <= nb) {
+        __m128i va = LoadSse(a + i);
+        DocID a_max = a[i + 3];
+        size_t block_start = j;
+        int matched = 0;
+        while (j + 4 <= nb && b[j + 3] < a_max) {
+            matched |= MatchSse(va, LoadSse(b + j));
+            j += 4;
+        }
+        if (j + 4 > nb) {
+            // b ran out mid-block; the tail redoes this block
+            j = block_start;
+            break;
+        }
+        matched |= MatchSse(va, LoadSse(b + j));
+        len += StoreLanesSse(va, ~matched & 0xF, out + len);
+        i += 4;
+    }
+    return AndNotTail(a, i, na, b, j, nb, out, len);
+}
+
+__attribute__((target("sse4.2")))
+size_t OrSse42(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out) {
+    if (na < 4 || nb < 4) {
+        return OrTail(a, 0, na, b, 0, nb, out, 0);
+    }
+    size_t i = 4, j = 4, len = 0;
+    __m128i lo, hi;
+    MergeSse(LoadSse(a), LoadSse(b), lo, hi);
+    len += StoreUniqueSse(_mm_set1_epi32(-1), lo, out + len);
+    __m128i last = lo;
+    while (i + 4 <= na && j + 4 <= nb) {
+        __m128i next;
+        if (a[i] <= b[j]) {
+            next = LoadSse(a + i);
+            i += 4;
+        } else {
+            next = LoadSse(b + j);
+            j += 4;
+        }
+        MergeSse(next, hi, lo, hi);
+        len += StoreUniqueSse(last, lo, out + len);
+        last = lo;
+    }
+
+    DocID pending[kSimdSlack];
+    size_t pending_len = StoreUniqueSse(last, hi, pending);
+    return OrLeftovers(pending, pending_len, a, i, na, b, j, nb, out, len);
+}
+
+__attribute__((target("avx2")))
+size_t AndAvx2(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out) {
+    size_t i = 0, j = 0, len = 0;
+    if (na >= 8 && nb >= 8) {
+        __m256i va = LoadAvx2(a);
+        __m256i vb = LoadAvx2(b);
+        while (true) {
+            len += StoreLanesAvx2(va, MatchAvx2(va, vb), out + len);
+            DocID a_max = a[i + 7];
+            DocID b_max = b[j + 7];
+            if (a_max <= b_max) {
+                i += 8;
+                if (i + 8 > na) break;
+                va = LoadAvx2(a + i);
+            }
+            if (b_max <= a_max) {
+                j += 8;
+                if (j + 8 > nb) break;
+                vb = LoadAvx2(b + j);
+            }
+        }
+    }
+    return AndTail(a, i, na, b, j, nb, out, len);
+}
+
+__attribute__((target("avx2")))
+size_t AndNotAvx2(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out) {
+    size_t i = 0, j = 0, len = 0;
+    while (i + 8 <= na && j + 8 <= nb) {
+        __m256i va = LoadAvx2(a + i);
+        DocID a_max = a[i + 7];
+        size_t block_start = j;
+        int matched = 0;
+        while (j + 8 <= nb && b[j + 7] < a_max) {
+            matched |= MatchAvx2(va, LoadAvx2(b + j));
+            j += 8;
+        }
+        if (j + 8 > nb) {
+            j = block_start;
+            break;
+        }
+        matched |= MatchAvx2(va, LoadAvx2(b + j));
+        len += StoreLanesAvx2(va, ~matched & 0xFF, out + len);
+        i += 8;
+    }
+    return AndNotTail(a, i, na, b, j, nb, out, len);
+}
+
+__attribute__((target("avx2")))
+size_t OrAvx2(const DocID* a, size_t na, const DocID* b, size_t nb, DocID* out) {
+    if (na < 8 || nb < 8) {
+        return OrTail(a, 0, na, b, 0, nb, out, 0);
+    }
+    size_t i = 8, j = 8, len = 0;
+    __m256i lo, hi;
+    MergeAvx2(LoadAvx2(a), LoadAvx2(b), lo, hi);
+    len += StoreUniqueAvx2(_mm256_set1_epi32(-1), lo, out + len);
+    __m256i last = lo;
+    while (i + 8 <= na && j + 8 <= nb) {
+        __m256i next;
+        if (a[i] <= b[j]) {
+            next = LoadAvx2(a + i);
+            i += 8;
+        } else {
+            next = LoadAvx2(b + j);
+            j += 8;
+        }
+        MergeAvx2(next, hi, lo, hi);
+        len += StoreUniqueAvx2(last, lo, out + len);
+        last = lo;
+    }
+
+    DocID pending[kSimdSlack];
+    size_t pending_len = StoreUniqueAvx2(last, hi, pending);
+    return OrLeftovers(pending, pending_len, a, i, na, b, j, nb, out, len);
+}
+
+} // namespace search::simd
+
+#endif // defined(__x86_64__) || defined(__i386__)
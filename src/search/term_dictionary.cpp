@@ -0,0 +1,120 @@
+#include "search/term_dictionary.hpp"
+#include "search/varint.hpp"
+#include <algorithm>
+
+namespace search {
+
+FrontCodedTerms FrontCodeTerms(const std::vector<std::string_view>& sorted_terms) {
+    FrontCodedTerms coded;
+    coded.block_offsets.reserve((sorted_terms.size() + kTermBlockSize - 1) / kTermBlockSize);
+    std::string_view prev;
+    for (size_t i = 0; i < sorted_terms.size(); ++i) {
+        std::string_view term = sorted_terms[i];
+        size_t shared = 0;
+        if (i % kTermBlockSize == 0) {
+            coded.block_offsets.push_back(static_cast<uint32_t>(coded.bytes.size()));
+        } else {
+            size_t limit = std::min(prev.size(), term.size());
+            while (shared < limit && prev[shared] == term[shared]) {
+                ++shared;
+            }
+            AppendVarint(coded.bytes, static_cast<uint32_t>(shared));
+        }
+        AppendVarint(coded.bytes, static_cast<uint32_t>(term.size() - shared));
+        coded.bytes.insert(coded.bytes.end(), term.begin() + shared, term.end());
+        prev = term;
+    }
+    return coded;
+}
+
+std::string_view TermDictionary::FirstTerm(size_t block) const {
+    uint32_t length;
+    const uint8_t* in = ReadVarint(bytes_ + block_offsets_[block], length);
+    return {reinterpret_cast<const char*>(in), length};
+}
+
+std::string TermDictionary::Term(size_t term_idx) const {
+    size_t block = term_idx / kTermBlockSize;
+    uint32_t length;
+    const uint8_t* in = ReadVarint(bytes_ + block_offsets_[block], length);
+    std::string term(reinterpret_cast<const char*>(in), length);
+    in += length;
+    for (size_t i = block * kTermBlockSize; i < term_idx; ++i) {
+        uint32_t shared;
+        in = ReadVarint(in, shared);
+        in = ReadVarint(in, length);
+        term.resize(shared);
+        term.append(reinterpret_cast<const char*>(in), length);
+        in += length;
+    }
+    return term;
+}
+
+std::pair<size_t, bool> TermDictionary::SeekInBlock(size_t block, std::string_view term) const {
+    size_t first = block * kTermBlockSize;
+    size_t end = std::min(first + kTermBlockSize, term_count_);
+    uint32_t length;
+    const uint8_t* in = ReadVarint(bytes_ + block_offsets_[block], length);
+    std::string current(reinterpret_cast<const char*>(in), length);
+    in += length;
+    for (size_t i = first; i < end; ++i) {
+        if (i > first) {
+            uint32_t shared;
+            in = ReadVarint(in, shared);
+            in = ReadVarint(in, length);
+            current.resize(shared);
+            current.append(reinterpret_cast<const char*>(in), length);
+            in += length;
+        }
+        if (current >= term) {
+            return {i, current == term};
+        }
+    }
+    return {end, false};
+}
+
+size_t TermDictionary::BlocksUpTo(std::string_view term) const {
+    size_t lo = 0, hi = BlockCount();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (FirstTerm(mid) <= term) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t TermDictionary::LowerBound(std::string_view term) const {
+    size_t blocks = BlocksUpTo(term);
+    return blocks == 0 ? 0 : SeekInBlock(blocks - 1, term).first;
+}
+
+std::optional<size_t> TermDictionary::Find(std::string_view term) const {
+    size_t blocks = BlocksUpTo(term);
+    if (blocks == 0) {
+        return std::nullopt;
+    }
+    auto [term_idx, found] = SeekInBlock(blocks - 1, term);
+    if (!found) {
+        return std::nullopt;
+    }
+    return term_idx;
+}
+
+std::pair<size_t, size_t> TermDictionary::PrefixRange(std::string_view prefix) const {
+    // Every term with the prefix sorts before the prefix with its last
+    // non-0xFF byte incremented
+    std::string successor(prefix);
+    while (!successor.empty() && static_cast<uint8_t>(successor.back()) == 0xFF) {
+        successor.pop_back();
+    }
+    if (successor.empty()) {
+        return {LowerBound(prefix), term_count_};
+    }
+    successor.back() = static_cast<char>(static_cast<uint8_t>(successor.back()) + 1);
+    return {LowerBound(prefix), LowerBound(successor)};
+}
+
+} // namespace search
@@ -2,6 +2,7 @@
 #include "text_processing/utf8_converter.hpp"
 #include "text_processing/tokenizer.hpp"
 #include <cwctype>
+#include <string_view>
 
 namespace {
 
@@ -11,6 +12,26 @@ constexpr wchar_t kOpNot = L'!';
 constexpr wchar_t kLeftParen = L'(';
 constexpr wchar_t kRightParen = L')';
 constexpr wchar_t kSpace = L' ';
+constexpr wchar_t kPrefixWildcard = L'*';
+constexpr wchar_t kQuote = L'"';
+// NEAR/k, matched after lowercasing
+constexpr std::wstring_view kNearOperator = L"near/";
+
+bool IsLatinLetter(wchar_t c) {
+    return c >= L'a' && c <= L'z';
+}
+
+// Length of a NEAR/k operator starting at i, or 0
+size_t NearOperatorLength(const std::wstring& query, size_t i) {
+    if (query.compare(i, kNearOperator.size(), kNearOperator) != 0 || (i > 0 && IsLatinLetter(query[i - 1]))) {
+        return 0;
+    }
+    size_t end = i + kNearOperator.size();
+    while (end < query.size() && iswdigit(query[end])) {
+        ++end;
+    }
+    return end > i + kNearOperator.size() ? end - i : 0;
+}
 
 bool IsOperatorChar(wchar_t c) {
     return c == kOpAnd1 || c == kOpOr1 || c == kOpNot || 
@@ -24,19 +45,45 @@ namespace text_processing {
 std::vector<std::wstring> TokenizeQuery(const std::string& query) {
     std::wstring wquery = Utf8ToWstring(query);
     
-    // Convert to lowercase for text parts
+    // Words are folded the same way as in documents, and Latin letters
+    // lowercased for NEAR/k
     for (auto& c : wquery) {
-        if (!IsOperatorChar(c) && c != kSpace) {
-            c = towlower(c);
+        if (IsRussianLetter(c)) {
+            c = FoldRussianLetter(c);
+        } else if (c >= L'A' && c <= L'Z') {
+            c += L'a' - L'A';
         }
     }
     
     std::vector<std::wstring> tokens;
     std::wstring current;
+    // Between quotes only words count; operators and wildcards are separators
+    bool in_phrase = false;
     
     for (size_t i = 0; i < wquery.length(); ++i) {
         wchar_t c = wquery[i];
         
+        if (c == kQuote) {
+            if (!current.empty()) {
+                tokens.push_back(current);
+                current.clear();
+            }
+            tokens.push_back(L"\"");
+            in_phrase = !in_phrase;
+            continue;
+        }
+
+        size_t near_length = in_phrase ? 0 : NearOperatorLength(wquery, i);
+        if (near_length > 0) {
+            if (!current.empty()) {
+                tokens.push_back(current);
+                current.clear();
+            }
+            tokens.push_back(L"NEAR/" + wquery.substr(i + kNearOperator.size(), near_length - kNearOperator.size()));
+            i += near_length - 1;
+            continue;
+        }
+
         if (c == kSpace) {
             if (!current.empty()) {
                 tokens.push_back(current);
@@ -45,7 +92,7 @@ std::vector<std::wstring> TokenizeQuery(const std::string& query) {
             continue;
         }
         
-        if (IsOperatorChar(c)) {
+        if (IsOperatorChar(c) && !in_phrase) {
             if (!current.empty()) {
                 tokens.push_back(current);
                 current.clear();
@@ -67,6 +114,11 @@ std::vector<std::wstring> TokenizeQuery(const std::string& query) {
             }
         } else if (IsRussianLetter(c)) {
             current += c;
+        } else if (c == kPrefixWildcard && !current.empty() && !in_phrase) {
+            // The wildcard stays on the token so the parser sees a prefix
+            current += c;
+            tokens.push_back(current);
+            current.clear();
         } else {
             // Other characters - treat as separators
             if (!current.empty()) {
@@ -0,0 +1,105 @@
+#include "text_processing/stem_cache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+constexpr uint64_t kFibonacciMultiplier = 11400714819323198485ULL;
+
+uint64_t LoadTwoChars(const wchar_t* chars) {
+    uint64_t chunk = 0;
+    std::memcpy(&chunk, chars, 2 * sizeof(wchar_t));
+    return chunk;
+}
+
+// Mixes the length with the first, middle and last two characters, in the
+// same few steps for every word: a loop over the characters costs as much as
+// stemming them. Only has to spread words over slots.
+uint64_t HashWord(std::wstring_view word) {
+    size_t n = word.size();
+    if (n < 2) {
+        return (n | (n > 0 ? static_cast<uint64_t>(word[0]) << 8 : 0)) * kFibonacciMultiplier;
+    }
+    uint64_t hash = (LoadTwoChars(word.data()) * kFibonacciMultiplier) ^ (LoadTwoChars(word.data() + n - 2) + n);
+    hash = ((hash ^ (hash >> 29)) * kFibonacciMultiplier) ^ LoadTwoChars(word.data() + n / 2 - 1);
+    return (hash ^ (hash >> 32)) * kFibonacciMultiplier;
+}
+
+} // anonymous namespace
+
+namespace text_processing {
+
+StemCache::StemCache(size_t slots) {
+    if (slots == 0) {
+        return;
+    }
+    size_t capacity = 1;
+    while (capacity < slots) {
+        capacity *= 2;
+    }
+    slots_.resize(capacity);
+}
+
+size_t StemCache::SlotIndex(std::wstring_view word) const {
+    return static_cast<size_t>(HashWord(word) >> 32) & (slots_.size() - 1);
+}
+
+const uint32_t* StemCache::Find(std::wstring_view word) const {
+    if (slots_.empty() || word.empty() || word.size() > kMaxWordLength) {
+        return nullptr;
+    }
+    const Slot& slot = slots_[SlotIndex(word)];
+    if (slot.length != word.size() || !std::equal(word.begin(), word.end(), slot.word)) {
+        return nullptr;
+    }
+    return &slot.value;
+}
+
+void StemCache::Insert(std::wstring_view word, uint32_t value) {
+    if (slots_.empty() || word.empty() || word.size() > kMaxWordLength) {
+        return;
+    }
+    Slot& slot = slots_[SlotIndex(word)];
+    if (slot.length == 0) {
+        ++entries_;
+    }
+    std::copy(word.begin(), word.end(), slot.word);
+    slot.length = static_cast<uint32_t>(word.size());
+    slot.value = value;
+}
+
+size_t SharedStemCache::StemLength(std::wstring_view word, Stemmer stemmer) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (bound_ && stemmer == stemmer_) {
+            if (const uint32_t* length = cache_.Find(word)) {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return *length;
+            }
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    size_t length = StemLengthRu(word, stemmer);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (!bound_) {
+        stemmer_ = stemmer;
+        bound_ = true;
+    }
+    if (stemmer == stemmer_) {
+        cache_.Insert(word, static_cast<uint32_t>(length));
+    }
+    return length;
+}
+
+StemCacheStats SharedStemCache::Stats() const {
+    StemCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    stats.entries = cache_.Entries();
+    stats.bytes = cache_.Bytes();
+    return stats;
+}
+
+} // namespace text_processing
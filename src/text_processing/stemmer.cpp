@@ -1,12 +1,15 @@
 #include "text_processing/stemmer.hpp"
-#include <vector>
+#include "text_processing/suffix_automaton.hpp"
+#include <array>
 
 namespace {
 
-constexpr size_t kMinWordLength = 3;
+using text_processing::SuffixAutomaton;
+using text_processing::SuffixAutomatonNodes;
+
 constexpr size_t kMinStemLength = 2;
 
-const std::vector<std::wstring> kEndings = {
+constexpr auto kLightEndings = std::to_array<std::wstring_view>({
     L"иями", L"ями", L"ами",
     L"ией", L"ий", L"ый", L"ой",
     L"ия", L"ья", L"ие", L"ье",
@@ -15,24 +18,166 @@ const std::vector<std::wstring> kEndings = {
     L"ом", L"ем",
     L"ах", L"ях",
     L"ы", L"и", L"а", L"я", L"о", L"е", L"у", L"ю"
-};
+});
+constexpr SuffixAutomaton<SuffixAutomatonNodes(kLightEndings)> kLightAutomaton(kLightEndings);
+
+// Snowball Russian (snowballstem.org/algorithms/russian). In each list the
+// first kAfterA... endings only count when they follow а or я, which stays.
+constexpr auto kPerfectiveGerunds = std::to_array<std::wstring_view>({
+    L"в", L"вши", L"вшись",
+    L"ив", L"ивши", L"ившись", L"ыв", L"ывши", L"ывшись"
+});
+constexpr int kPerfectiveGerundsAfterA = 3;
+
+constexpr auto kAdjectives = std::to_array<std::wstring_view>({
+    L"ее", L"ие", L"ые", L"ое", L"ими", L"ыми", L"ей", L"ий", L"ый", L"ой", L"ем", L"им", L"ым",
+    L"ом", L"его", L"ого", L"ему", L"ому", L"их", L"ых", L"ую", L"юю", L"ая", L"яя", L"ою", L"ею"
+});
+
+constexpr auto kParticiples = std::to_array<std::wstring_view>({
+    L"ем", L"нн", L"вш", L"ющ", L"щ",
+    L"ивш", L"ывш", L"ующ"
+});
+constexpr int kParticiplesAfterA = 5;
+
+constexpr auto kReflexives = std::to_array<std::wstring_view>({L"ся", L"сь"});
+
+constexpr auto kVerbs = std::to_array<std::wstring_view>({
+    L"ла", L"на", L"ете", L"йте", L"ли", L"й", L"л", L"ем", L"н", L"ло", L"но", L"ет", L"ют",
+    L"ны", L"ть", L"ешь", L"нно",
+    L"ила", L"ыла", L"ена", L"ейте", L"уйте", L"ите", L"или", L"ыли", L"ей", L"уй", L"ил", L"ыл",
+    L"им", L"ым", L"ен", L"ило", L"ыло", L"ено", L"ят", L"ует", L"уют", L"ит", L"ыт", L"ены",
+    L"ить", L"ыть", L"ишь", L"ую", L"ю"
+});
+constexpr int kVerbsAfterA = 17;
+
+constexpr auto kNouns = std::to_array<std::wstring_view>({
+    L"а", L"ев", L"ов", L"ие", L"ье", L"е", L"иями", L"ями", L"ами", L"еи", L"ии", L"и",
+    L"ией", L"ей", L"ой", L"ий", L"й", L"иям", L"ям", L"ием", L"ем", L"ам", L"ом", L"о",
+    L"у", L"ах", L"иях", L"ях", L"ы", L"ь", L"ию", L"ью", L"ю", L"ия", L"ья", L"я"
+});
+
+constexpr auto kDerivationals = std::to_array<std::wstring_view>({L"ост", L"ость"});
+
+constexpr auto kTidyUps = std::to_array<std::wstring_view>({L"ейш", L"ейше", L"н", L"ь"});
+constexpr int kSuperlative = 1; // last of the superlatives
+constexpr int kDoubleN = 2;
+
+constexpr SuffixAutomaton<SuffixAutomatonNodes(kPerfectiveGerunds)> kPerfectiveGerundAutomaton(kPerfectiveGerunds);
+constexpr SuffixAutomaton<SuffixAutomatonNodes(kAdjectives)> kAdjectiveAutomaton(kAdjectives);
+constexpr SuffixAutomaton<SuffixAutomatonNodes(kParticiples)> kParticipleAutomaton(kParticiples);
+constexpr SuffixAutomaton<SuffixAutomatonNodes(kReflexives)> kReflexiveAutomaton(kReflexives);
+constexpr SuffixAutomaton<SuffixAutomatonNodes(kVerbs)> kVerbAutomaton(kVerbs);
+constexpr SuffixAutomaton<SuffixAutomatonNodes(kNouns)> kNounAutomaton(kNouns);
+constexpr SuffixAutomaton<SuffixAutomatonNodes(kDerivationals)> kDerivationalAutomaton(kDerivationals);
+constexpr SuffixAutomaton<SuffixAutomatonNodes(kTidyUps)> kTidyUpAutomaton(kTidyUps);
+
+constexpr const char* kStemmerNames[] = {"light", "snowball"};
+
+bool IsVowel(wchar_t c) {
+    return c == L'а' || c == L'е' || c == L'и' || c == L'о' || c == L'у' ||
+           c == L'ы' || c == L'э' || c == L'ю' || c == L'я';
+}
+
+size_t LightStemLength(std::wstring_view word) {
+    // Of the endings that leave more than kMinStemLength letters the longest
+    // one is stripped
+    return word.length() - kLightAutomaton.Longest(word, kMinStemLength + 1).length;
+}
+
+// Removes the longest ending of word[0, end) from the automaton that lies in
+// the region from rv on; an ending before after_a in its list only counts
+// after а or я. Returns whether one was removed.
+template <typename Automaton>
+bool RemoveEnding(const Automaton& automaton, int after_a, std::wstring_view word, size_t rv, size_t& end) {
+    auto match = automaton.Longest(word.substr(0, end), rv);
+    if (match.length == 0) {
+        return false;
+    }
+    size_t start = end - match.length;
+    if (match.ending < after_a && (start <= rv || (word[start - 1] != L'а' && word[start - 1] != L'я'))) {
+        return false;
+    }
+    end = start;
+    return true;
+}
+
+size_t SnowballStemLength(std::wstring_view word) {
+    // RV starts after the first vowel; R2 after a vowel and a consonant that
+    // follow another vowel and consonant
+    size_t rv = word.size(), r2 = word.size();
+    size_t i = 0;
+    auto skip_to = [&word, &i](bool vowel) {
+        while (i < word.size() && IsVowel(word[i]) != vowel) {
+            ++i;
+        }
+        return i++ < word.size();
+    };
+    if (skip_to(true)) {
+        rv = i;
+        if (skip_to(false) && skip_to(true) && skip_to(false)) {
+            r2 = i;
+        }
+    }
+
+    size_t end = word.size();
+    if (!RemoveEnding(kPerfectiveGerundAutomaton, kPerfectiveGerundsAfterA, word, rv, end)) {
+        RemoveEnding(kReflexiveAutomaton, 0, word, rv, end);
+        if (RemoveEnding(kAdjectiveAutomaton, 0, word, rv, end)) {
+            RemoveEnding(kParticipleAutomaton, kParticiplesAfterA, word, rv, end);
+        } else if (!RemoveEnding(kVerbAutomaton, kVerbsAfterA, word, rv, end)) {
+            RemoveEnding(kNounAutomaton, 0, word, rv, end);
+        }
+    }
+
+    if (end > rv && word[end - 1] == L'и') {
+        --end;
+    }
+
+    auto derivational = kDerivationalAutomaton.Longest(word.substr(0, end), rv);
+    if (derivational.length > 0 && end - derivational.length >= r2) {
+        end -= derivational.length;
+    }
+
+    auto tidy_up = kTidyUpAutomaton.Longest(word.substr(0, end), rv);
+    if (tidy_up.length > 0 && tidy_up.ending <= kSuperlative) {
+        end -= tidy_up.length;
+        if (end >= rv + 2 && word[end - 1] == L'н' && word[end - 2] == L'н') {
+            --end;
+        }
+    } else if (tidy_up.ending == kDoubleN) {
+        if (end >= rv + 2 && word[end - 2] == L'н') {
+            --end;
+        }
+    } else if (tidy_up.length > 0) {
+        --end;
+    }
+    return end;
+}
 
 } // anonymous namespace
 
 namespace text_processing {
 
-std::wstring StemRu(const std::wstring& word) {
-    if (word.length() <= kMinWordLength)
-        return word;
+const char* StemmerName(Stemmer stemmer) {
+    return kStemmerNames[static_cast<uint32_t>(stemmer)];
+}
 
-    for (const auto& end : kEndings) {
-        if (word.length() > end.length() + kMinStemLength &&
-            word.compare(word.length() - end.length(), end.length(), end) == 0) {
-            return word.substr(0, word.length() - end.length());
+std::optional<Stemmer> ParseStemmer(std::string_view name) {
+    for (uint32_t i = 0; i < std::size(kStemmerNames); ++i) {
+        if (name == kStemmerNames[i]) {
+            return static_cast<Stemmer>(i);
         }
     }
-    return word;
+    return std::nullopt;
 }
 
-} // namespace text_processing
+size_t StemLengthRu(std::wstring_view word, Stemmer stemmer) {
+    return stemmer == Stemmer::kSnowball ? SnowballStemLength(word) : LightStemLength(word);
+}
 
+std::wstring StemRu(const std::wstring& word, Stemmer stemmer) {
+    return word.substr(0, StemLengthRu(word, stemmer));
+}
+
+} // namespace text_processing
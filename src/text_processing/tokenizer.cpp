@@ -1,6 +1,7 @@
 #include "text_processing/tokenizer.hpp"
-#include "text_processing/utf8_converter.hpp"
-#include <cwctype>
+#include <array>
+#include <cstdint>
+#include <cstring>
 
 namespace {
 
@@ -10,6 +11,37 @@ constexpr wchar_t kRussianUpperA = L'А';
 constexpr wchar_t kRussianUpperYa = L'Я';
 constexpr wchar_t kRussianLowerYo = L'ё';
 constexpr wchar_t kRussianUpperYo = L'Ё';
+constexpr wchar_t kRussianLowerYe = L'е';
+
+// Code points U+0400..U+047F are the two-byte sequences D0 80..D1 BF
+constexpr wchar_t kTwoByteCyrillicBase = 0x400;
+constexpr uint8_t kCyrillicLeadMask = 0xFE;
+constexpr uint8_t kCyrillicLead = 0xD0;
+constexpr uint8_t kContinuationMask = 0xC0;
+constexpr uint8_t kContinuation = 0x80;
+constexpr uint64_t kAsciiHighBits = 0x8080808080808080ULL;
+
+constexpr wchar_t Fold(wchar_t c) {
+    if (c >= kRussianUpperA && c <= kRussianUpperYa) {
+        c += kRussianLowerA - kRussianUpperA;
+    }
+    if (c == kRussianLowerYo || c == kRussianUpperYo) {
+        return kRussianLowerYe;
+    }
+    return c >= kRussianLowerA && c <= kRussianLowerYa ? c : 0;
+}
+
+// Folded letter, or 0, for each code point U+0400..U+047F, indexed by the
+// low bit of the lead byte and the payload bits of the continuation byte
+constexpr std::array<wchar_t, 128> MakeCyrillicFoldTable() {
+    std::array<wchar_t, 128> table{};
+    for (size_t i = 0; i < table.size(); ++i) {
+        table[i] = Fold(kTwoByteCyrillicBase + static_cast<wchar_t>(i));
+    }
+    return table;
+}
+
+constexpr std::array<wchar_t, 128> kCyrillicFold = MakeCyrillicFoldTable();
 
 } // anonymous namespace
 
@@ -21,29 +53,63 @@ bool IsRussianLetter(wchar_t c) {
            c == kRussianLowerYo || c == kRussianUpperYo;
 }
 
-std::vector<std::wstring> TokenizeRu(const std::string& text) {
-    std::wstring wtext = Utf8ToWstring(text);
-
-    for (auto& c : wtext)
-        c = towlower(c);
+wchar_t FoldRussianLetter(wchar_t c) {
+    return Fold(c);
+}
 
-    std::vector<std::wstring> tokens;
-    std::wstring current;
-
-    for (wchar_t c : wtext) {
-        if (IsRussianLetter(c)) {
-            current += c;
-        } else if (!current.empty()) {
-            tokens.push_back(current);
-            current.clear();
+bool TokenScanner::Next(std::wstring_view& token) {
+    const auto* data = reinterpret_cast<const uint8_t*>(text_.data());
+    size_t size = text_.size();
+    token_.clear();
+    while (pos_ < size) {
+        uint8_t lead = data[pos_];
+        if (lead < kContinuation && token_.empty()) {
+            // Nothing ASCII belongs to a word, so skip it a word at a time
+            uint64_t chunk;
+            while (pos_ + sizeof(chunk) <= size) {
+                std::memcpy(&chunk, data + pos_, sizeof(chunk));
+                if (chunk & kAsciiHighBits) {
+                    break;
+                }
+                pos_ += sizeof(chunk);
+            }
+            while (pos_ < size && data[pos_] < kContinuation) {
+                ++pos_;
+            }
+            continue;
+        }
+        // Lead and continuation bytes of any other sequence are separators
+        // one by one, as none of them can be mistaken for D0 or D1
+        wchar_t letter = 0;
+        if ((lead & kCyrillicLeadMask) == kCyrillicLead && pos_ + 1 < size &&
+            (data[pos_ + 1] & kContinuationMask) == kContinuation) {
+            letter = kCyrillicFold[((lead & 1) << 6) | (data[pos_ + 1] & ~kContinuationMask)];
+            pos_ += 2;
+        } else {
+            ++pos_;
+        }
+        if (letter != 0) {
+            token_.push_back(letter);
+        } else if (!token_.empty()) {
+            token = token_;
+            return true;
         }
     }
+    if (token_.empty()) {
+        return false;
+    }
+    token = token_;
+    return true;
+}
 
-    if (!current.empty())
-        tokens.push_back(current);
-
+std::vector<std::wstring> TokenizeRu(const std::string& text) {
+    std::vector<std::wstring> tokens;
+    TokenScanner scanner(text);
+    std::wstring_view token;
+    while (scanner.Next(token)) {
+        tokens.emplace_back(token);
+    }
     return tokens;
 }
 
 } // namespace text_processing
-
@@ -1,10 +1,62 @@
 #include "text_processing/utf8_converter.hpp"
+#include <cstdint>
 
 namespace {
 
-std::wstring_convert<std::codecvt_utf8<wchar_t>>& GetConverter() {
-    static std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-    return converter;
+constexpr char32_t kReplacementChar = 0xFFFD;
+constexpr char32_t kMaxCodePoint = 0x10FFFF;
+constexpr char32_t kSurrogateFirst = 0xD800;
+constexpr char32_t kSurrogateLast = 0xDFFF;
+
+bool IsContinuation(uint8_t byte) {
+    return (byte & 0xC0) == 0x80;
+}
+
+// Decodes the sequence at str[i] and advances i past it; a malformed
+// sequence yields U+FFFD and consumes one byte
+char32_t DecodeOne(const std::string& str, size_t& i) {
+    uint8_t lead = static_cast<uint8_t>(str[i]);
+    size_t length;
+    char32_t code_point;
+    char32_t min_code_point;
+    if (lead < 0x80) {
+        ++i;
+        return lead;
+    } else if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        code_point = lead & 0x1F;
+        min_code_point = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        code_point = lead & 0x0F;
+        min_code_point = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        code_point = lead & 0x07;
+        min_code_point = 0x10000;
+    } else {
+        ++i;
+        return kReplacementChar;
+    }
+    if (i + length > str.size()) {
+        ++i;
+        return kReplacementChar;
+    }
+    for (size_t k = 1; k < length; ++k) {
+        uint8_t byte = static_cast<uint8_t>(str[i + k]);
+        if (!IsContinuation(byte)) {
+            ++i;
+            return kReplacementChar;
+        }
+        code_point = (code_point << 6) | (byte & 0x3F);
+    }
+    if (code_point < min_code_point || code_point > kMaxCodePoint ||
+        (code_point >= kSurrogateFirst && code_point <= kSurrogateLast)) {
+        ++i;
+        return kReplacementChar;
+    }
+    i += length;
+    return code_point;
 }
 
 } // anonymous namespace
@@ -12,14 +64,39 @@ std::wstring_convert<std::codecvt_utf8<wchar_t>>& GetConverter() {
 namespace text_processing {
 
 std::wstring Utf8ToWstring(const std::string& str) {
-    auto& conv = GetConverter();
-    return conv.from_bytes(str);
+    std::wstring result;
+    result.reserve(str.size());
+    for (size_t i = 0; i < str.size();) {
+        result.push_back(static_cast<wchar_t>(DecodeOne(str, i)));
+    }
+    return result;
 }
 
 std::string WstringToUtf8(const std::wstring& wstr) {
-    auto& conv = GetConverter();
-    return conv.to_bytes(wstr);
+    std::string result;
+    result.reserve(wstr.size() * 2);
+    for (wchar_t c : wstr) {
+        auto code_point = static_cast<char32_t>(c);
+        if (code_point > kMaxCodePoint || (code_point >= kSurrogateFirst && code_point <= kSurrogateLast)) {
+            code_point = kReplacementChar;
+        }
+        if (code_point < 0x80) {
+            result.push_back(static_cast<char>(code_point));
+        } else if (code_point < 0x800) {
+            result.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        } else if (code_point < 0x10000) {
+            result.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        } else {
+            result.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+    }
+    return result;
 }
 
 } // namespace text_processing
-
@@ -2,6 +2,7 @@
 #include "search/boolean_search.hpp"
 #include "text_processing/utf8_converter.hpp"
 #include <httplib.h>
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <json/json.h>
@@ -11,6 +12,8 @@ namespace {
 
 constexpr const char* kContentTypeJson = "application/json";
 constexpr const char* kContentTypeText = "text/plain; charset=utf-8";
+constexpr Json::UInt kDefaultLimit = 20;
+constexpr Json::UInt kMaxLimit = 1000;
 
 std::string CreateJsonResponse(const std::string& status, const std::string& data) {
     Json::Value root;
@@ -30,7 +33,12 @@ std::string CreateErrorResponse(const std::string& message) {
     return Json::writeString(builder, root);
 }
 
-std::optional<std::string> ParseJsonQuery(const std::string& body) {
+struct SearchRequest {
+    std::string query;
+    search::SearchOptions options;
+};
+
+std::optional<SearchRequest> ParseSearchRequest(const std::string& body) {
     Json::Value root;
     Json::CharReaderBuilder builder;
     std::string errors;
@@ -44,15 +52,49 @@ std::optional<std::string> ParseJsonQuery(const std::string& body) {
         return std::nullopt;
     }
     
-    return root["query"].asString();
+    SearchRequest request;
+    request.query = root["query"].asString();
+    request.options.explain = root["explain"].isBool() && root["explain"].asBool();
+    request.options.ranked = root["ranked"].isBool() && root["ranked"].asBool();
+    // An empty page would send a client following next_offset in circles
+    request.options.max_docs = std::clamp(root["limit"].isUInt() ? root["limit"].asUInt() : kDefaultLimit, 1u, kMaxLimit);
+    request.options.offset = root["offset"].isUInt() ? root["offset"].asUInt() : 0;
+    return request;
+}
+
+// Equal for requests that must get the same response
+std::string CacheKey(const search::QueryNode& query, const search::SearchOptions& options) {
+    return search::CanonicalQuery(query) + (options.ranked ? "\nranked " : "\n") +
+           std::to_string(options.offset) + " " + std::to_string(options.max_docs);
+}
+
+Json::Value PlanToJson(const search::PlanNode& plan) {
+    Json::Value node;
+    node["op"] = search::PlanOpName(plan.op);
+    if (plan.op == search::PlanOp::kTerm) {
+        node["term"] = plan.term;
+    }
+    if (plan.op == search::PlanOp::kNear) {
+        node["distance"] = plan.distance;
+    }
+    node["estimate"] = static_cast<Json::UInt64>(plan.estimate);
+    node["matches"] = static_cast<Json::UInt64>(plan.matches);
+    if (!plan.children.empty()) {
+        Json::Value children(Json::arrayValue);
+        for (const auto& child : plan.children) {
+            children.append(PlanToJson(*child));
+        }
+        node["children"] = children;
+    }
+    return node;
 }
 
 } // anonymous namespace
 
 namespace web {
 
-Server::Server(indexing::Indexer& indexer, database::MongoDBClient& db_client, int port)
-    : indexer_(indexer), db_client_(db_client), port_(port), server_impl_(nullptr) {
+Server::Server(indexing::Indexer& indexer, int port, size_t cache_bytes)
+    : indexer_(indexer), port_(port), server_impl_(nullptr), cache_(cache_bytes) {
 }
 
 void Server::Start() {
@@ -68,13 +110,13 @@ void Server::Start() {
     });
     
     server->Post("/search", [this](const httplib::Request& req, httplib::Response& res) {
-        auto query_opt = ParseJsonQuery(req.body);
-        if (!query_opt.has_value()) {
+        auto request = ParseSearchRequest(req.body);
+        if (!request.has_value()) {
             res.status = 400;
             res.set_content(CreateErrorResponse("Invalid JSON or missing 'query' field"), kContentTypeJson);
             return;
         }
-        res.set_content(HandleSearch(query_opt.value()), kContentTypeJson);
+        res.set_content(HandleSearch(request->query, request->options), kContentTypeJson);
     });
     
     std::cout << "Server starting on port " << port_ << std::endl;
@@ -90,24 +132,56 @@ void Server::Stop() {
     }
 }
 
-std::string Server::HandleSearch(const std::string& query) {
+std::string Server::HandleSearch(const std::string& query, const search::SearchOptions& options) {
     try {
-        auto& index = indexer_.GetIndex();
-        auto result = search::BooleanSearchRu(query, index);
+        // Held to the end, so an index generation published meanwhile does
+        // not change the documents under this request
+        auto snapshot = indexer_.Snapshot();
+        auto parsed = search::ParseQueryRu(query, snapshot->Stemmer(), &stem_cache_);
+
+        // Explained results carry a plan computed for this request only
+        std::string cache_key;
+        std::shared_ptr<const search::SearchResult> cached;
+        if (!options.explain) {
+            cache_key = CacheKey(*parsed, options);
+            cached = cache_.Find(cache_key, snapshot->Generation());
+        }
+        if (!cached) {
+            auto fresh = std::make_shared<const search::SearchResult>(search::EvaluateQuery(*parsed, *snapshot, options));
+            if (!options.explain) {
+                cache_.Insert(cache_key, snapshot->Generation(), fresh);
+            }
+            cached = std::move(fresh);
+        }
+        const auto& result = *cached;
         
         Json::Value root;
         root["status"] = "success";
-        root["count"] = static_cast<Json::UInt64>(result.Size());
+        root["count"] = static_cast<Json::UInt64>(result.count);
+        root["count_exact"] = result.count_exact;
+        root["offset"] = static_cast<Json::UInt64>(options.offset);
+        root["limit"] = static_cast<Json::UInt64>(options.max_docs);
+        size_t next_offset = options.offset + result.docs.size();
+        if (result.docs.size() == options.max_docs && (next_offset < result.count || !result.count_exact)) {
+            root["next_offset"] = static_cast<Json::UInt64>(next_offset);
+        }
+        if (result.plan) {
+            root["plan"] = PlanToJson(*result.plan);
+        }
         
+        // The segment stores what a response shows, so no database lookup is needed
         Json::Value documents(Json::arrayValue);
-        auto mongo_documents = db_client_.FindByIds(result);
-        for (const auto& mongo_document : mongo_documents) {
+        for (size_t i = 0; i < result.docs.size(); ++i) {
+            auto metadata = snapshot->Metadata(result.docs[i]);
             Json::Value doc_obj;
-            doc_obj["id"] = mongo_document.id;
-            doc_obj["pageid"] = mongo_document.pageid;
-            doc_obj["title"] = mongo_document.title;
-            doc_obj["url"] = mongo_document.url;
-            doc_obj["created_at"] = mongo_document.created_at;
+            doc_obj["id"] = std::string(metadata.id);
+            doc_obj["pageid"] = metadata.pageid;
+            doc_obj["title"] = std::string(metadata.title);
+            doc_obj["url"] = std::string(metadata.url);
+            doc_obj["created_at"] = metadata.created_at;
+            if (!result.scores.empty()) {
+                doc_obj["score"] = result.scores[i];
+            }
             documents.append(doc_obj);
         }
         root["documents"] = documents;
@@ -132,6 +206,14 @@ std::string Server::HandleStats() {
         root["avg_token_length"] = (stats.total_tokens > 0 ? (double)stats.total_chars / stats.total_tokens : 0.0);
         root["indexing_time_seconds"] = stats.elapsed_seconds;
         root["indexing_speed_kb_per_sec"] = (stats.elapsed_seconds > 0 ? (stats.total_bytes / 1024.0) / stats.elapsed_seconds : 0.0);
+        root["indexing_threads"] = static_cast<Json::UInt64>(stats.threads);
+        root["stemmer"] = text_processing::StemmerName(indexer_.Snapshot()->Stemmer());
+        
+        Json::Value phases;
+        phases["fetch_seconds"] = stats.fetch_seconds;
+        phases["tokenize_seconds"] = stats.tokenize_seconds;
+        phases["merge_seconds"] = stats.merge_seconds;
+        root["indexing_phases"] = phases;
         
         Json::Value frequencies(Json::arrayValue);
         for (size_t i = 0; i < stats.top_frequencies.size(); ++i) {
@@ -141,6 +223,52 @@ std::string Server::HandleStats() {
             frequencies.append(freq_obj);
         }
         root["top_frequencies"] = frequencies;
+
+        auto cache_stats = cache_.Stats();
+        Json::Value cache;
+        cache["hits"] = static_cast<Json::UInt64>(cache_stats.hits);
+        cache["misses"] = static_cast<Json::UInt64>(cache_stats.misses);
+        cache["hit_rate"] = cache_stats.hits + cache_stats.misses > 0
+            ? static_cast<double>(cache_stats.hits) / (cache_stats.hits + cache_stats.misses) : 0.0;
+        cache["insertions"] = static_cast<Json::UInt64>(cache_stats.insertions);
+        cache["evictions"] = static_cast<Json::UInt64>(cache_stats.evictions);
+        cache["rejections"] = static_cast<Json::UInt64>(cache_stats.rejections);
+        cache["invalidations"] = static_cast<Json::UInt64>(cache_stats.invalidations);
+        cache["entries"] = static_cast<Json::UInt64>(cache_stats.entries);
+        cache["bytes"] = static_cast<Json::UInt64>(cache_stats.bytes);
+        cache["capacity_bytes"] = static_cast<Json::UInt64>(cache_stats.capacity_bytes);
+        root["query_cache"] = cache;
+
+        auto query_stem_stats = stem_cache_.Stats();
+        Json::Value stem_cache;
+        Json::Value indexing_stems;
+        indexing_stems["hits"] = static_cast<Json::UInt64>(stats.stem_cache_hits);
+        indexing_stems["misses"] = static_cast<Json::UInt64>(stats.stem_cache_misses);
+        indexing_stems["hit_rate"] = stats.stem_cache_hits + stats.stem_cache_misses > 0
+            ? static_cast<double>(stats.stem_cache_hits) / (stats.stem_cache_hits + stats.stem_cache_misses) : 0.0;
+        indexing_stems["bytes"] = static_cast<Json::UInt64>(stats.stem_cache_bytes);
+        stem_cache["indexing"] = indexing_stems;
+        Json::Value query_stems;
+        query_stems["hits"] = static_cast<Json::UInt64>(query_stem_stats.hits);
+        query_stems["misses"] = static_cast<Json::UInt64>(query_stem_stats.misses);
+        query_stems["hit_rate"] = query_stem_stats.hits + query_stem_stats.misses > 0
+            ? static_cast<double>(query_stem_stats.hits) / (query_stem_stats.hits + query_stem_stats.misses) : 0.0;
+        query_stems["entries"] = static_cast<Json::UInt64>(query_stem_stats.entries);
+        query_stems["bytes"] = static_cast<Json::UInt64>(query_stem_stats.bytes);
+        stem_cache["query"] = query_stems;
+        root["stem_cache"] = stem_cache;
+
+        auto incremental_stats = indexer_.GetIncrementalStats();
+        Json::Value incremental;
+        incremental["live_docs"] = static_cast<Json::UInt64>(indexer_.Snapshot()->DocCount());
+        incremental["polls"] = static_cast<Json::UInt64>(incremental_stats.polls);
+        incremental["documents_added"] = static_cast<Json::UInt64>(incremental_stats.documents_added);
+        incremental["documents_replaced"] = static_cast<Json::UInt64>(incremental_stats.documents_replaced);
+        incremental["delta_docs"] = static_cast<Json::UInt64>(incremental_stats.delta_docs);
+        incremental["merges"] = static_cast<Json::UInt64>(incremental_stats.merges);
+        incremental["last_merge_seconds"] = incremental_stats.last_merge_seconds;
+        incremental["watermark"] = incremental_stats.watermark;
+        root["incremental"] = incremental;
         
         Json::StreamWriterBuilder builder;
         return Json::writeString(builder, root);